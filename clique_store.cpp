@@ -0,0 +1,166 @@
+#include "clique_store.hpp"
+
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+
+namespace clique_store {
+
+/*
+ * The file format, all in the native byte order:
+ *  - the 8 magic bytes "CLQSET01"
+ *  - int64: C, the number of cliques
+ *  - int64: the total number of nodes, over all cliques
+ *  - int64 * (C+1): the offsets
+ *  - int32 * total: the nodes
+ * Everything is then naturally aligned, so the mapped file can be used in place.
+ */
+static const char MAGIC[8] = { 'C', 'L', 'Q', 'S', 'E', 'T', '0', '1' };
+static const size_t HEADER_BYTES = sizeof(MAGIC) + 2 * sizeof(int64_t);
+
+clique_set :: clique_set() : owned_offsets(1, 0), C(0), mapping(NULL), mapping_length(0) {
+	this->point_at_owned();
+}
+clique_set :: ~clique_set() {
+	if(this->mapping)
+		munmap(this->mapping, this->mapping_length);
+}
+
+void clique_set :: swap(clique_set &other) { // the pointers into the owned vectors stay valid, as swapping vectors doesn't move their contents
+	this->owned_offsets.swap(other.owned_offsets);
+	this->owned_nodes.swap(other.owned_nodes);
+	std :: swap(this->offsets, other.offsets);
+	std :: swap(this->nodes, other.nodes);
+	std :: swap(this->C, other.C);
+	std :: swap(this->mapping, other.mapping);
+	std :: swap(this->mapping_length, other.mapping_length);
+}
+
+static void write_or_throw(FILE *f, const void *p, const size_t n, const string &file_name) {
+	if(n > 0 && fwrite(p, 1, n, f) != n)
+		throw std :: runtime_error("couldn't write the cliques to \"" + file_name + "\"");
+}
+void clique_set :: save(const string &file_name) const {
+	FILE * f = fopen(file_name.c_str(), "wb");
+	if(!f)
+		throw std :: runtime_error("couldn't create \"" + file_name + "\"");
+	try {
+		const int64_t header[2] = { int64_t(this->C), this->total_nodes() };
+		write_or_throw(f, MAGIC, sizeof(MAGIC), file_name);
+		write_or_throw(f, header, sizeof(header), file_name);
+		write_or_throw(f, this->offsets, sizeof(int64_t) * (this->C + 1), file_name);
+		write_or_throw(f, this->nodes, sizeof(int32_t) * this->total_nodes(), file_name);
+	} catch (...) {
+		fclose(f);
+		throw;
+	}
+	if(fclose(f) != 0)
+		throw std :: runtime_error("couldn't write the cliques to \"" + file_name + "\"");
+}
+
+void clique_set :: map_file(const string &file_name) {
+	assert(this->C == 0 && !this->mapping);
+	const int fd = open(file_name.c_str(), O_RDONLY);
+	if(fd == -1)
+		throw std :: runtime_error("couldn't open \"" + file_name + "\": " + strerror(errno));
+	struct stat st;
+	if(fstat(fd, &st) != 0 || size_t(st.st_size) < HEADER_BYTES) {
+		close(fd);
+		throw std :: runtime_error("\"" + file_name + "\" is not a clique file");
+	}
+	void * m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // the mapping stays valid
+	if(m == MAP_FAILED)
+		throw std :: runtime_error("couldn't map \"" + file_name + "\": " + strerror(errno));
+	const char * bytes = static_cast<const char *>(m);
+	int64_t header[2];
+	memcpy(header, bytes + sizeof(MAGIC), sizeof(header));
+	const int64_t num_cliques = header[0];
+	const int64_t num_nodes = header[1];
+	if(memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0
+			|| num_cliques < 0 || num_nodes < 0
+			|| size_t(st.st_size) != HEADER_BYTES + sizeof(int64_t) * (num_cliques + 1) + sizeof(int32_t) * num_nodes) {
+		munmap(m, st.st_size);
+		throw std :: runtime_error("\"" + file_name + "\" is not a clique file, or is truncated");
+	}
+	const int64_t * offsets = reinterpret_cast<const int64_t *>(bytes + HEADER_BYTES);
+	bool in_order = offsets[0] == 0 && offsets[num_cliques] == num_nodes; // then no clique reaches outside the mapping
+	for(int64_t c = 0; c < num_cliques && in_order; c++)
+		in_order = offsets[c] <= offsets[c+1];
+	if(!in_order) {
+		munmap(m, st.st_size);
+		throw std :: runtime_error("\"" + file_name + "\" is a corrupt clique file");
+	}
+	this->mapping = m;
+	this->mapping_length = st.st_size;
+	this->C = num_cliques;
+	this->offsets = offsets;
+	this->nodes = reinterpret_cast<const int32_t *>(bytes + HEADER_BYTES + sizeof(int64_t) * (num_cliques + 1));
+	std :: vector<int64_t>().swap(this->owned_offsets);
+	std :: vector<int32_t>().swap(this->owned_nodes);
+}
+
+static const size_t WRITER_BUFFER_BYTES = 1 << 20;
+clique_file_writer :: clique_file_writer(const string &_file_name) : file_name(_file_name), offsets(NULL), nodes(NULL), C(0), total(0) {
+	this->offsets = fopen(this->file_name.c_str(), "wb");
+	if(!this->offsets)
+		throw std :: runtime_error("couldn't create \"" + this->file_name + "\"");
+	this->nodes = fopen((this->file_name + ".nodes").c_str(), "w+b");
+	if(!this->nodes) {
+		fclose(this->offsets);
+		remove(this->file_name.c_str());
+		throw std :: runtime_error("couldn't create \"" + this->file_name + ".nodes\"");
+	}
+	setvbuf(this->offsets, NULL, _IOFBF, WRITER_BUFFER_BYTES);
+	setvbuf(this->nodes, NULL, _IOFBF, WRITER_BUFFER_BYTES);
+	const int64_t header[2] = { 0, 0 }; // filled in by close()
+	write_or_throw(this->offsets, MAGIC, sizeof(MAGIC), this->file_name);
+	write_or_throw(this->offsets, header, sizeof(header), this->file_name);
+	write_or_throw(this->offsets, &this->total, sizeof(this->total), this->file_name);
+}
+clique_file_writer :: ~clique_file_writer() {
+	if(this->offsets) { // close() wasn't called, or failed
+		fclose(this->offsets);
+		fclose(this->nodes);
+		remove(this->file_name.c_str());
+		remove((this->file_name + ".nodes").c_str());
+	}
+}
+void clique_file_writer :: push_back(const int32_t *b, const int32_t *e) {
+	assert(this->offsets);
+	write_or_throw(this->nodes, b, sizeof(int32_t) * (e - b), this->file_name + ".nodes");
+	this->total += e - b;
+	++ this->C;
+	write_or_throw(this->offsets, &this->total, sizeof(this->total), this->file_name);
+}
+void clique_file_writer :: close() {
+	assert(this->offsets);
+	rewind(this->nodes);
+	std :: vector<char> buf(WRITER_BUFFER_BYTES);
+	size_t got;
+	while((got = fread(&buf.front(), 1, buf.size(), this->nodes)) > 0)
+		write_or_throw(this->offsets, &buf.front(), got, this->file_name);
+	if(ferror(this->nodes))
+		throw std :: runtime_error("couldn't read back \"" + this->file_name + ".nodes\"");
+	const int64_t header[2] = { this->C, this->total };
+	if(fseek(this->offsets, sizeof(MAGIC), SEEK_SET) != 0)
+		throw std :: runtime_error("couldn't write the cliques to \"" + this->file_name + "\"");
+	write_or_throw(this->offsets, header, sizeof(header), this->file_name);
+	const bool ok = fclose(this->offsets) == 0;
+	this->offsets = NULL;
+	fclose(this->nodes);
+	remove((this->file_name + ".nodes").c_str());
+	if(!ok) {
+		remove(this->file_name.c_str());
+		throw std :: runtime_error("couldn't write the cliques to \"" + this->file_name + "\"");
+	}
+}
+
+} // namespace clique_store
@@ -0,0 +1,107 @@
+#ifndef _CLIQUE_STORE_HPP_
+#define _CLIQUE_STORE_HPP_
+
+/*
+ * All the cliques, in one flat CSR-style store: an offsets array and one contiguous array
+ * of node ids. That's 8 bytes of overhead per clique, rather than a heap allocation and a
+ * 24-byte vector header each, and consecutive cliques are adjacent in memory.
+ * A clique_view is a (begin, end) pair into the store. It's cheap to copy, and has just
+ * enough of the interface of a const vector<int32_t> for the code that reads cliques.
+ * The store can be saved to a file, and later mapped straight back in with mmap(2).
+ */
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cassert>
+#include <cstdio>
+#include <stdint.h>
+
+namespace clique_store {
+
+class clique_view { // the nodes of one clique, in increasing order
+	const int32_t * b;
+	const int32_t * e;
+public:
+	typedef const int32_t * const_iterator;
+	clique_view() : b(NULL), e(NULL) {}
+	clique_view(const int32_t *_b, const int32_t *_e) : b(_b), e(_e) {}
+	const_iterator begin() const { return this->b; }
+	const_iterator end() const { return this->e; }
+	size_t size() const { return this->e - this->b; }
+	bool empty() const { return this->b == this->e; }
+	int32_t at(const size_t n) const { assert(n < this->size()); return this->b[n]; }
+	int32_t operator[] (const size_t n) const { return this->b[n]; }
+	int32_t front() const { assert(!this->empty()); return this->b[0]; }
+	int32_t back() const { assert(!this->empty()); return this->e[-1]; }
+};
+
+class clique_set {
+	// Either owned (in the two vectors) or mapped from a file. Either way, read through the two pointers.
+	std :: vector<int64_t> owned_offsets; // C+1 entries. Clique c is nodes[offsets[c], offsets[c+1])
+	std :: vector<int32_t> owned_nodes;
+	const int64_t * offsets;
+	const int32_t * nodes;
+	size_t C;
+	void * mapping;
+	size_t mapping_length;
+	clique_set(const clique_set &); // not copyable
+	clique_set & operator= (const clique_set &);
+	void point_at_owned() {
+		this->offsets = &this->owned_offsets.front();
+		this->nodes = this->owned_nodes.empty() ? NULL : &this->owned_nodes.front();
+	}
+public:
+	clique_set();
+	~clique_set();
+	size_t size() const { return this->C; }
+	int64_t total_nodes() const { return this->offsets[this->C]; }
+	clique_view at(const size_t c) const {
+		assert(c < this->C);
+		return clique_view(this->nodes + this->offsets[c], this->nodes + this->offsets[c+1]);
+	}
+	clique_view operator[] (const size_t c) const {
+		return clique_view(this->nodes + this->offsets[c], this->nodes + this->offsets[c+1]);
+	}
+	void push_back(const int32_t *b, const int32_t *e) { // the nodes must be sorted
+		assert(!this->mapping);
+		this->owned_nodes.insert(this->owned_nodes.end(), b, e);
+		this->owned_offsets.push_back(this->owned_nodes.size());
+		++ this->C;
+		this->point_at_owned();
+	}
+	void push_back(const clique_view &cl) {
+		this->push_back(cl.begin(), cl.end());
+	}
+	void reserve(const size_t num_cliques, const int64_t num_nodes) {
+		this->owned_offsets.reserve(num_cliques + 1);
+		this->owned_nodes.reserve(num_nodes);
+		this->point_at_owned();
+	}
+	void swap(clique_set &other); // e.g. to replace the cliques with a reordered copy
+	void save(const std :: string &file_name) const; // throws std :: runtime_error
+	void map_file(const std :: string &file_name);   // replaces the contents of this (empty) set with the mapped file. Throws std :: runtime_error
+};
+
+class clique_file_writer { // writes cliques straight into a file in the clique_set :: save format, without holding them. Then map_file() it
+	const std :: string file_name;
+	FILE * offsets; // file_name itself: the header, then the offsets
+	FILE * nodes;   // file_name + ".nodes", appended to the offsets by close()
+	int64_t C;
+	int64_t total;
+	clique_file_writer(const clique_file_writer &);
+	clique_file_writer & operator= (const clique_file_writer &);
+public:
+	explicit clique_file_writer(const std :: string &file_name); // throws std :: runtime_error
+	~clique_file_writer(); // if close() wasn't called, the partial file is removed
+	void push_back(const int32_t *b, const int32_t *e); // the nodes must be sorted. Throws std :: runtime_error
+	void push_back(const clique_view &cl) {
+		this->push_back(cl.begin(), cl.end());
+	}
+	size_t size() const { return this->C; }
+	void close(); // throws std :: runtime_error
+};
+
+} // namespace clique_store
+
+#endif
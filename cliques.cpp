@@ -1,10 +1,14 @@
 #include "cliques.hpp"
+#include "output.hpp"
+#include "threads.hpp"
 #include "misc/list_with_constant_size.hpp"
 #include <set>
 #include <map>
 #include <list>
 #include <vector>
 #include <stdexcept>
+#include <fstream>
+#include <sstream>
 #include <algorithm>
 #include <limits>
 #include <sys/stat.h>
@@ -19,11 +23,98 @@ typedef int32_t V;
 typedef misc :: list_with_constant_size<V> list_of_ints;
 typedef set<V> not_type;
 
-struct CliqueReceiver;
-static void cliquesWorker(const SimpleIntGraph &g, CliqueReceiver *send_cliques_here, unsigned int minimumSize, vector<V> & Compsub, list_of_ints Not, list_of_ints Candidates);
-static void findCliques(const SimpleIntGraph &g, CliqueReceiver *cliquesOut, unsigned int minimumSize, const bool verbose);
-static void cliquesForOneNode(const SimpleIntGraph &g, CliqueReceiver *send_cliques_here, int minimumSize, V v);
-static void find_node_with_fewest_discs(int &fewestDisc, int &fewestDiscVertex, bool &fewestIsInCands, const list_of_ints &Not, const list_of_ints &Candidates, const SimpleIntGraph &g);
+/*
+ * The enumeration core is a template over two things:
+ *  - Adjacency : a concrete, non-virtual, copy of the graph, built once at the top of findCliques.
+ *                It must offer  degree(v), neighbours(v) (a sorted [begin,end) range) and are_connected(u,v).
+ *  - Receiver  : anything with a (non-virtual) receive_unsorted_clique(const vector<V> &).
+ * The runtime choice of Adjacency is made once, in findCliques, so the inner loops never go
+ * through graph :: VerySimpleGraphInterface and the compiler is free to inline them.
+ */
+
+struct neighbour_range { // a sorted run of neighbours, borrowed from an adjacency structure
+	const V * first;
+	const V * last;
+	const V * begin() const { return first; }
+	const V * end() const { return last; }
+	size_t size() const { return last - first; }
+};
+
+class csr_adjacency { // compressed sparse rows: one offsets array and one array of all the neighbours
+protected:
+	vector<int64_t> offsets; // numNodes()+1 entries
+	vector<V> all_neighbours;
+public:
+	explicit csr_adjacency(const SimpleIntGraph &g) {
+		const V N = g->numNodes();
+		this->offsets.reserve(N+1);
+		this->all_neighbours.reserve(2 * int64_t(g->numRels()));
+		this->offsets.push_back(0);
+		for(V v = 0; v < N; v++) {
+			const vector<int32_t> &neighs_of_v = g->neighbouring_nodes_in_order(v);
+			this->all_neighbours.insert(this->all_neighbours.end(), neighs_of_v.begin(), neighs_of_v.end());
+			this->offsets.push_back(int64_t(this->all_neighbours.size()));
+		}
+	}
+	V numNodes() const { return V(this->offsets.size() - 1); }
+	int degree(const V v) const { return int(this->offsets[v+1] - this->offsets[v]); }
+	neighbour_range neighbours(const V v) const {
+		const V * base = this->all_neighbours.empty() ? NULL : &this->all_neighbours.front();
+		neighbour_range r = { base + this->offsets[v], base + this->offsets[v+1] };
+		return r;
+	}
+	bool are_connected(const V u, const V v) const {
+		const neighbour_range r = this->neighbours(u);
+		return binary_search(r.begin(), r.end(), v);
+	}
+};
+
+class bitmatrix_adjacency : public csr_adjacency { // as csr_adjacency, but with an N*N bit matrix to make are_connected() O(1)
+	vector<uint64_t> bits;
+	size_t words_per_row;
+public:
+	static const int64_t max_matrix_bytes = 64 << 20; // 64 MB. That's about 23,000 nodes
+	static bool suitable_for(const SimpleIntGraph &g) {
+		const int64_t N = g->numNodes();
+		return N * ((N+63)/64) * 8 <= max_matrix_bytes;
+	}
+	explicit bitmatrix_adjacency(const SimpleIntGraph &g) : csr_adjacency(g), words_per_row((g->numNodes()+63)/64) {
+		const V N = this->numNodes();
+		this->bits.resize(size_t(N) * this->words_per_row, 0);
+		for(V v = 0; v < N; v++) {
+			const neighbour_range r = this->neighbours(v);
+			for(const V *n = r.begin(); n != r.end(); ++n)
+				this->bits[size_t(v) * this->words_per_row + (*n >> 6)] |= uint64_t(1) << (*n & 63);
+		}
+	}
+	bool are_connected(const V u, const V v) const {
+		return (this->bits[size_t(u) * this->words_per_row + (v >> 6)] >> (v & 63)) & 1;
+	}
+};
+
+class interface_adjacency { // straight through the graph interface, with no copy. For when only a few neighbourhoods will be visited
+	const SimpleIntGraph g;
+public:
+	explicit interface_adjacency(const SimpleIntGraph &_g) : g(_g) {}
+	V numNodes() const { return this->g->numNodes(); }
+	int degree(const V v) const { return int(this->g->neighbouring_nodes_in_order(v).size()); }
+	neighbour_range neighbours(const V v) const {
+		const vector<int32_t> &neighs_of_v = this->g->neighbouring_nodes_in_order(v);
+		const V * base = neighs_of_v.empty() ? NULL : &neighs_of_v.front();
+		neighbour_range r = { base, base + neighs_of_v.size() };
+		return r;
+	}
+	bool are_connected(const V u, const V v) const { return this->g->are_connected(u, v); }
+};
+
+template <typename Adjacency, typename Receiver>
+static void cliquesWorker(const Adjacency &g, Receiver *send_cliques_here, unsigned int minimumSize, vector<V> & Compsub, list_of_ints Not, list_of_ints Candidates);
+template <typename Receiver>
+static void findCliques(const SimpleIntGraph &g, Receiver *cliquesOut, unsigned int minimumSize, const bool verbose);
+template <typename Adjacency, typename Receiver>
+static void cliquesForOneNode(const Adjacency &g, Receiver *send_cliques_here, int minimumSize, V v);
+template <typename Adjacency>
+static void find_node_with_fewest_discs(int &fewestDisc, int &fewestDiscVertex, bool &fewestIsInCands, const list_of_ints &Not, const list_of_ints &Candidates, const Adjacency &g);
 static const bool verbose = false;
 
 /*
@@ -32,13 +123,9 @@ static const bool verbose = false;
  * Not ?
  */
 
-struct CliqueReceiver {
-	virtual void receive_unsorted_clique (std::vector<V> clique) = 0;
-	virtual ~CliqueReceiver() {}
-};
-
-static void cliquesForOneNode(const SimpleIntGraph &g, CliqueReceiver *send_cliques_here, int minimumSize, V v) {
-	const int d = g->degree(v);
+template <typename Adjacency, typename Receiver>
+static void cliquesForOneNode(const Adjacency &g, Receiver *send_cliques_here, int minimumSize, V v) {
+	const int d = g.degree(v);
 	if(d + 1 < minimumSize)
 		return; // Obviously no chance of a clique if the degree is too small.
 
@@ -52,9 +139,9 @@ static void cliquesForOneNode(const SimpleIntGraph &g, CliqueReceiver *send_cliq
 	// copy those above the split into Candidates
 	// there shouldn't ever be a neighbour equal to the split, this'd mean a self-loop
 	{
-		const vector<int32_t> &neighs_of_v = g->neighbouring_nodes_in_order(v);
+		const neighbour_range neighs_of_v = g.neighbours(v);
 		int32_t last_neighbour_id = -1;
-		for(vector<int32_t> :: const_iterator i = neighs_of_v.begin(); i != neighs_of_v.end(); i++) {
+		for(const V * i = neighs_of_v.begin(); i != neighs_of_v.end(); i++) {
 			const int neighbour_id = *i;
 
 			if(neighbour_id < v)
@@ -72,15 +159,16 @@ static void cliquesForOneNode(const SimpleIntGraph &g, CliqueReceiver *send_cliq
 	cliquesWorker(g, send_cliques_here, minimumSize, Compsub, Not, Candidates);
 }
 
-static inline void tryCandidate (const SimpleIntGraph & g, CliqueReceiver *send_cliques_here, unsigned int minimumSize, vector<V> & Compsub, const list_of_ints & Not, const list_of_ints & Candidates, const V selected) {
+template <typename Adjacency, typename Receiver>
+static inline void tryCandidate (const Adjacency & g, Receiver *send_cliques_here, unsigned int minimumSize, vector<V> & Compsub, const list_of_ints & Not, const list_of_ints & Candidates, const V selected) {
 	// it *might* be the case that the 'selected' node is still in Candidates, but we can rely on the intersection to remove it (assuming no self loops! )
 	assert(!Compsub.empty());
 	Compsub.push_back(selected); // Compsub does *not* have to be ordered. I might try to enforce that in future though.
 
 	list_of_ints CandidatesNew_;
 	list_of_ints NotNew_;
-	
-	const vector<int32_t> &neighs_of_selected = g->neighbouring_nodes_in_order(selected);
+
+	const neighbour_range neighs_of_selected = g.neighbours(selected);
 	set_intersection(Candidates.get().begin()            , Candidates.get().end()
 			, neighs_of_selected.begin(), neighs_of_selected.end()
 			,back_inserter(CandidatesNew_));
@@ -93,8 +181,8 @@ static inline void tryCandidate (const SimpleIntGraph & g, CliqueReceiver *send_
 	Compsub.pop_back(); // we must restore Compsub, it was passed by reference
 }
 
-static void cliquesWorker(const SimpleIntGraph &g, CliqueReceiver *send_cliques_here, unsigned int minimumSize, vector<V> & Compsub, list_of_ints Not, list_of_ints Candidates) {
-	assert(g != NULL);
+template <typename Adjacency, typename Receiver>
+static void cliquesWorker(const Adjacency &g, Receiver *send_cliques_here, unsigned int minimumSize, vector<V> & Compsub, list_of_ints Not, list_of_ints Candidates) {
 	// p2p         511462                   (10)
 	// authors000                  (250)    (<4)
 	// authors010  212489     5.3s (4.013)
@@ -129,7 +217,7 @@ static void cliquesWorker(const SimpleIntGraph &g, CliqueReceiver *send_cliques_
 				if(
 						fewestDisc >0 // speed trick. if it's zero, the call to are_connected is redundant
 						&& v!=fewestDiscVertex // deal with it later - see { if(fewestIsInCands) ... } below
-						&& !g->are_connected(v, fewestDiscVertex)
+						&& !g.are_connected(v, fewestDiscVertex)
 					) { // just in case fewestDiscVertex is in Cands
 					unless(Candidates.size() + Compsub.size() >= minimumSize) return;
 					i = Candidates.erase(i);
@@ -159,31 +247,45 @@ static void cliquesWorker(const SimpleIntGraph &g, CliqueReceiver *send_cliques_
 	 */
 }
 
-struct CliquesToStdout : public CliqueReceiver {
+template <typename Out>
+struct CliquesToText { // Out is an output :: buffered_writer, or an output :: text_buffer
 	int n;
 	std :: map<size_t, int32_t> cliqueFrequencies;
-	const graph :: NetworkInterfaceConvertedToString *g;
-	CliquesToStdout(const graph :: NetworkInterfaceConvertedToString *_g) : n(0), g(_g) {}
-	virtual void receive_unsorted_clique (vector<V> Compsub) {
-		sort(Compsub.begin(), Compsub.end());
+	const output :: node_name_cache &names;
+	Out &out;
+	vector<V> sorted; // reused for every clique, to save on allocations
+	CliquesToText(const output :: node_name_cache &_names, Out &_out) : n(0), names(_names), out(_out) {}
+	void receive_unsorted_clique (const vector<V> &Compsub) {
+		this->sorted.assign(Compsub.begin(), Compsub.end());
+		sort(this->sorted.begin(), this->sorted.end());
 		bool firstField = true;
-		if(Compsub.size() >= 3) {
-			++ this -> cliqueFrequencies[Compsub.size()];
-			for(vector<V> :: const_iterator v = Compsub.begin(); v != Compsub.end(); ++v) {
+		if(this->sorted.size() >= 3) {
+			++ this -> cliqueFrequencies[this->sorted.size()];
+			for(vector<V> :: const_iterator v = this->sorted.begin(); v != this->sorted.end(); ++v) {
 				if(!firstField)
-					std :: cout	<< ' ';
-				std :: cout <<  g->node_name_as_string(*v) ;
+					this->out.put(' ');
+				this->out.append_name(this->names, *v);
 				firstField = false;
 			}
-			std :: cout << endl;
+			this->out.put('\n');
 			this -> n++;
 		}
 	}
 };
+typedef CliquesToText<output :: buffered_writer> CliquesToStdout;
 
 struct SelfLoopsNotSupportedException {
 };
-static void findCliques(const SimpleIntGraph &g, CliqueReceiver *send_cliques_here, unsigned int minimumSize, const bool verbose) {
+template <typename Adjacency, typename Receiver>
+static void findCliques_on(const Adjacency &g, Receiver *send_cliques_here, unsigned int minimumSize, const bool verbose) {
+	for(V v = 0; v < g.numNodes(); v++) {
+		if(verbose && v && v % 100 ==0)
+			cerr << "processing node: " << v << " ..." <<  endl;
+		cliquesForOneNode(g, send_cliques_here, minimumSize, v);
+	}
+}
+static void check_before_finding_cliques(const SimpleIntGraph &g, unsigned int minimumSize) {
+	assert(g != NULL);
 	unless(minimumSize >= 3) throw std :: invalid_argument("the minimumSize for findCliques() must be at least 3");
 
 	for(int32_t r = 0; r < g->numRels(); r++) {
@@ -191,35 +293,161 @@ static void findCliques(const SimpleIntGraph &g, CliqueReceiver *send_cliques_he
 		unless(eps.first < eps.second) // no selfloops allowed
 			throw SelfLoopsNotSupportedException();
 	}
-
-	for(V v = 0; v < (V) g->numNodes(); v++) {
-		if(verbose && v && v % 100 ==0)
-			cerr << "processing node: " << v << " ..." <<  endl;
-		cliquesForOneNode(g, send_cliques_here, minimumSize, v);
+}
+template <typename Receiver>
+static void findCliques(const SimpleIntGraph &g, Receiver *send_cliques_here, unsigned int minimumSize, const bool verbose) {
+	check_before_finding_cliques(g, minimumSize);
+
+	// pick the concrete adjacency structure once, here. Everything below is non-virtual.
+	if(bitmatrix_adjacency :: suitable_for(g)) {
+		const bitmatrix_adjacency adj(g);
+		findCliques_on(adj, send_cliques_here, minimumSize, verbose);
+	} else {
+		const csr_adjacency adj(g);
+		findCliques_on(adj, send_cliques_here, minimumSize, verbose);
+	}
+}
+/*
+ * Parallel enumeration. The root vertices are cut into consecutive ranges, "chunks".
+ * Each worker claims the next chunk, finds every clique rooted in it, into a chunk-local
+ * receiver, and hands the finished chunk to a threads :: reorder_buffer. The calling
+ * thread takes finished chunks back out and consumes them (e.g. writes them out).
+ * If in_order, the output is exactly what the single-threaded enumeration would give.
+ */
+template <typename Adjacency, typename Chunk>
+struct enumeration_worker : public threads :: runnable {
+	const Adjacency &g;
+	threads :: reorder_buffer<Chunk> &buffer;
+	const Chunk &prototype; // each chunk starts as a copy of this
+	const unsigned int minimumSize;
+	const V roots_per_chunk;
+	enumeration_worker(const Adjacency &_g, threads :: reorder_buffer<Chunk> &_buffer, const Chunk &_prototype, unsigned int _minimumSize, V _roots_per_chunk)
+		: g(_g), buffer(_buffer), prototype(_prototype), minimumSize(_minimumSize), roots_per_chunk(_roots_per_chunk) {}
+	virtual void run() {
+		int64_t chunk_id;
+		while(-1 != (chunk_id = this->buffer.claim())) {
+			Chunk *c = new Chunk(this->prototype);
+			const V first_root = V(chunk_id * this->roots_per_chunk);
+			const V last_root = V(min(int64_t(this->g.numNodes()), (chunk_id+1) * this->roots_per_chunk));
+			for(V v = first_root; v < last_root; v++)
+				cliquesForOneNode(this->g, c, this->minimumSize, v);
+			this->buffer.finish(chunk_id, c);
+		}
+	}
+};
+template <typename Adjacency, typename Chunk, typename Consumer>
+static void findCliques_parallel_on(const Adjacency &g, const Chunk &prototype, Consumer &consume, unsigned int minimumSize, const int num_threads, const bool in_order) {
+	assert(num_threads >= 1);
+	const int64_t N = g.numNodes();
+	const V roots_per_chunk = V(max(int64_t(1), min(int64_t(4096), N / (256 * num_threads)))); // plenty of chunks, for load balancing
+	const int64_t num_chunks = (N + roots_per_chunk - 1) / roots_per_chunk;
+	threads :: reorder_buffer<Chunk> buffer(num_chunks, 4 * num_threads, in_order);
+
+	vector< enumeration_worker<Adjacency, Chunk> * > workers;
+	vector< threads :: thread * > running;
+	try {
+		for(int t = 0; t < num_threads; t++) {
+			workers.push_back(new enumeration_worker<Adjacency, Chunk>(g, buffer, prototype, minimumSize, roots_per_chunk));
+			running.push_back(new threads :: thread(*workers.back()));
+		}
+	} catch (std :: runtime_error &) { // couldn't start them all. Stop the ones that did start before the buffer goes
+		buffer.cancel();
+		For(r, running)
+			delete *r; // joins
+		For(w, workers)
+			delete *w;
+		throw;
+	}
+	int64_t chunk_id;
+	while(Chunk *c = buffer.release(chunk_id)) {
+		const V first_root = V(chunk_id * roots_per_chunk);
+		const V last_root = V(min(N, (chunk_id+1) * roots_per_chunk));
+		consume(*c, first_root, last_root);
+		delete c;
+	}
+	for(int t = 0; t < num_threads; t++) {
+		delete running.at(t); // joins
+		delete workers.at(t);
+	}
+}
+template <typename Chunk, typename Consumer>
+static void findCliques_parallel(const SimpleIntGraph &g, const Chunk &prototype, Consumer &consume, unsigned int minimumSize, const int num_threads, const bool in_order) {
+	check_before_finding_cliques(g, minimumSize);
+	if(bitmatrix_adjacency :: suitable_for(g)) {
+		const bitmatrix_adjacency adj(g);
+		findCliques_parallel_on(adj, prototype, consume, minimumSize, num_threads, in_order);
+	} else {
+		const csr_adjacency adj(g);
+		findCliques_parallel_on(adj, prototype, consume, minimumSize, num_threads, in_order);
 	}
 }
-void cliquesToStdout(const graph :: NetworkInterfaceConvertedToString * net, unsigned int minimumSize /* = 3*/ ) {
+
+struct TextChunk { // the cliques from one range of roots, rendered, waiting to be printed
+	output :: text_buffer text;
+	CliquesToText<output :: text_buffer> receiver;
+	TextChunk(const output :: node_name_cache &names) : receiver(names, text) {}
+	TextChunk(const TextChunk &other) : receiver(other.receiver.names, text) {}
+	void receive_unsorted_clique (const vector<V> &Compsub) {
+		this->receiver.receive_unsorted_clique(Compsub);
+	}
+};
+struct TextChunksToStdout { // the consumer. Copies each chunk's text into the output, and keeps the stats
+	output :: buffered_writer &out;
+	int n;
+	std :: map<size_t, int32_t> cliqueFrequencies;
+	const bool verbose;
+	TextChunksToStdout(output :: buffered_writer &_out, bool _verbose) : out(_out), n(0), verbose(_verbose) {}
+	void operator() (const TextChunk &c, V first_root, V last_root) {
+		if(!c.text.bytes.empty())
+			this->out.append(&c.text.bytes.front(), c.text.bytes.size());
+		this->n += c.receiver.n;
+		For(freq, c.receiver.cliqueFrequencies)
+			this->cliqueFrequencies[freq->first] += freq->second;
+		if(this->verbose)
+			for(V v = first_root; v < last_root; v++)
+				if(v && v % 100 == 0)
+					cerr << "processing node: " << v << " ..." <<  endl;
+	}
+};
+
+void cliquesToStdout(const graph :: NetworkInterfaceConvertedToString * net, unsigned int minimumSize /* = 3*/, int num_threads /* = 1 */, bool deterministic /* = false */) {
 	assert(minimumSize >= 3);
+	assert(num_threads >= 1);
 
-	CliquesToStdout send_cliques_here(net);
-	findCliques(net->get_plain_graph(), & send_cliques_here, minimumSize, true);
-	cerr << send_cliques_here.n << " cliques found" << endl;
-	if(send_cliques_here.n > 0) {
-		assert(!send_cliques_here.cliqueFrequencies.empty());
-		const size_t biggest_clique_found = send_cliques_here.cliqueFrequencies.rbegin()->first;
+	const output :: node_name_cache names(net); // render every name just once, rather than once per clique it's in
+	output :: buffered_writer out(stdout);
+	int n;
+	std :: map<size_t, int32_t> cliqueFrequencies;
+	if(num_threads == 1) {
+		CliquesToStdout send_cliques_here(names, out);
+		findCliques(net->get_plain_graph(), & send_cliques_here, minimumSize, true);
+		n = send_cliques_here.n;
+		cliqueFrequencies.swap(send_cliques_here.cliqueFrequencies);
+	} else {
+		const TextChunk prototype(names);
+		TextChunksToStdout consume(out, true);
+		findCliques_parallel(net->get_plain_graph(), prototype, consume, minimumSize, num_threads, deterministic);
+		n = consume.n;
+		cliqueFrequencies.swap(consume.cliqueFrequencies);
+	}
+	out.flush();
+	cerr << n << " cliques found" << endl;
+	if(n > 0) {
+		assert(!cliqueFrequencies.empty());
+		const size_t biggest_clique_found = cliqueFrequencies.rbegin()->first;
 		for(size_t i = minimumSize; i <= biggest_clique_found; i++) {
-			cerr << send_cliques_here.cliqueFrequencies[i] << "\t#" << i << endl;
+			cerr << cliqueFrequencies[i] << "\t#" << i << endl;
 		}
 	}
 
 }
 
-struct CliquesToSortedVectorFunctor : public CliqueReceiver {
+struct CliquesToSortedVectorFunctor {
 	std :: vector< std :: vector<int32_t> > & output_vector;
 	CliquesToSortedVectorFunctor(std :: vector< std :: vector<int32_t> > & _output_vector) : output_vector(_output_vector) {}
-	virtual void receive_unsorted_clique (vector<int32_t> new_clique) {
-		sort(new_clique.begin(), new_clique.end());
+	void receive_unsorted_clique (const vector<int32_t> &new_clique) {
 		this->output_vector.push_back(new_clique);
+		sort(this->output_vector.back().begin(), this->output_vector.back().end());
 	}
 };
 void cliquesToVector          (const graph :: NetworkInterfaceConvertedToString * net, unsigned int minimumSize, std :: vector< std :: vector<int32_t> > & output_vector ) {
@@ -228,33 +456,425 @@ void cliquesToVector          (const graph :: NetworkInterfaceConvertedToString
 	findCliques(net->get_plain_graph(), & send_cliques_here, minimumSize, false);
 }
 
-static int32_t count_disconnections(const set<int> &cands, const int32_t v, const SimpleIntGraph &g) {
-	const vector<int> &v_neighs = g->neighbouring_nodes_in_order(v);
-	vector<int32_t> intersection;
-	set_intersection( cands.begin(), cands.end()
-			, v_neighs.begin(), v_neighs.end()
-			, back_inserter(intersection)
-			);
-	const int32_t num_connections = int32_t(intersection.size());
+struct CliquesToCallback { // sorts each clique into a reusable buffer, and lends it to the callback
+	clique_callback & callback;
+	vector<V> sorted;
+	CliquesToCallback(clique_callback & _callback) : callback(_callback) {}
+	void receive_unsorted_clique (const vector<V> &Compsub) {
+		this->sorted.assign(Compsub.begin(), Compsub.end());
+		sort(this->sorted.begin(), this->sorted.end());
+		this->callback.receive_sorted_clique(&this->sorted.front(), this->sorted.size());
+	}
+};
+void cliquesToCallback        (SimpleIntGraph g, unsigned int minimumSize, clique_callback & callback) {
+	CliquesToCallback send_cliques_here(callback);
+	findCliques(g, & send_cliques_here, minimumSize, false);
+}
 
+struct CliquesTouchingToCallback { // passes on only the cliques with at least one touched node in them
+	const vector<V> & touched; // sorted
+	CliquesToCallback to_callback;
+	CliquesTouchingToCallback(const vector<V> & _touched, clique_callback & callback) : touched(_touched), to_callback(callback) {}
+	void receive_unsorted_clique (const vector<V> &Compsub) {
+		For(v, Compsub)
+			if(binary_search(this->touched.begin(), this->touched.end(), *v)) {
+				this->to_callback.receive_unsorted_clique(Compsub);
+				return;
+			}
+	}
+};
+void cliquesTouchingNodesToCallback (SimpleIntGraph g, unsigned int minimumSize, const std :: vector<int32_t> & touched_nodes, clique_callback & callback) {
+	assert(g != NULL);
+	unless(minimumSize >= 3) throw std :: invalid_argument("the minimumSize for findCliques() must be at least 3");
+	vector<V> touched(touched_nodes);
+	sort(touched.begin(), touched.end());
+	touched.erase(unique(touched.begin(), touched.end()), touched.end());
 	/*
-	int currentDiscs = 0;
-	for( list_of_ints :: const_iterator i = Candidates.get().begin(); i != Candidates.get().end(); i++) {
-		V v2 = *i;
-		if(!g->are_connected(v, v2)) {
-			++currentDiscs;
+	 * cliquesForOneNode(v) finds exactly the cliques whose smallest node is v. A clique
+	 * with a touched node in it has its smallest node either there, or among that node's
+	 * neighbours; so those are the only roots we need.
+	 */
+	vector<V> roots(touched);
+	For(t, touched) {
+		const vector<int32_t> &neighs = g->neighbouring_nodes_in_order(*t);
+		roots.insert(roots.end(), neighs.begin(), neighs.end());
+	}
+	sort(roots.begin(), roots.end());
+	roots.erase(unique(roots.begin(), roots.end()), roots.end());
+	const interface_adjacency adj(g);
+	CliquesTouchingToCallback send_cliques_here(touched, callback);
+	For(root, roots)
+		cliquesForOneNode(adj, & send_cliques_here, minimumSize, *root);
+}
+
+typedef pair<V, V> edge; // always with first < second
+static edge ordered(const pair<int32_t, int32_t> &e) {
+	return e.first < e.second ? edge(e.first, e.second) : edge(e.second, e.first);
+}
+static bool find_removed_edge(const vector<V> &cl, const set<edge> &removed, edge &found) { // cl is sorted
+	for(size_t i = 0; i < cl.size(); i++)
+		for(size_t j = i+1; j < cl.size(); j++)
+			if(removed.count(edge(cl[i], cl[j]))) {
+				found = edge(cl[i], cl[j]);
+				return true;
+			}
+	return false;
+}
+static bool is_maximal(const interface_adjacency &g, const vector<V> &cl) { // cl must be a clique of g. Is there a node connected to all of it?
+	assert(!cl.empty() && cl.back() < g.numNodes()); // cl is sorted, and has no node that's left the graph
+	const neighbour_range first = g.neighbours(cl.front());
+	vector<V> common(first.begin(), first.end()); // never includes any node of cl itself, as there are no self loops
+	vector<V> narrowed;
+	for(size_t i = 1; i < cl.size() && !common.empty(); i++) {
+		const neighbour_range r = g.neighbours(cl[i]);
+		narrowed.clear();
+		set_intersection(common.begin(), common.end(), r.begin(), r.end(), back_inserter(narrowed));
+		common.swap(narrowed);
+	}
+	return common.empty();
+}
+struct CliquesToDelta { // passes on the cliques not seen before as clique_added
+	clique_delta_callback & callback;
+	set< vector<V> > & seen;
+	vector<V> sorted;
+	CliquesToDelta(clique_delta_callback & _callback, set< vector<V> > & _seen) : callback(_callback), seen(_seen) {}
+	void receive_sorted_clique (const vector<V> &cl) {
+		if(this->seen.insert(cl).second)
+			this->callback.clique_added(&cl.front(), cl.size());
+	}
+	void receive_unsorted_clique (const vector<V> &Compsub) {
+		this->sorted.assign(Compsub.begin(), Compsub.end());
+		sort(this->sorted.begin(), this->sorted.end());
+		this->receive_sorted_clique(this->sorted);
+	}
+};
+struct MaximalToDelta { // passes on, as CliquesToDelta does, only the cliques that are maximal in the whole graph
+	const interface_adjacency & adj;
+	CliquesToDelta & to_delta;
+	vector<V> sorted;
+	MaximalToDelta(const interface_adjacency & _adj, CliquesToDelta & _to_delta) : adj(_adj), to_delta(_to_delta) {}
+	void receive_unsorted_clique (const vector<V> &Compsub) {
+		this->sorted.assign(Compsub.begin(), Compsub.end());
+		sort(this->sorted.begin(), this->sorted.end());
+		if(is_maximal(this->adj, this->sorted))
+			this->to_delta.receive_sorted_clique(this->sorted);
+	}
+};
+void cliqueDeltaToCallback    (SimpleIntGraph g, unsigned int minimumSize
+		, const std :: vector< std :: pair<int32_t, int32_t> > & added_edges
+		, const std :: vector< std :: pair<int32_t, int32_t> > & removed_edges
+		, const std :: vector< std :: vector<int32_t> > & old_cliques
+		, clique_delta_callback & callback) {
+	assert(g != NULL);
+	unless(minimumSize >= 3) throw std :: invalid_argument("the minimumSize for findCliques() must be at least 3");
+	const interface_adjacency adj(g);
+	set<edge> removed;
+	For(e, removed_edges)
+		removed.insert(ordered(*e));
+	set<V> ends_of_added_edges;
+	For(e, added_edges) {
+		ends_of_added_edges.insert(e->first);
+		ends_of_added_edges.insert(e->second);
+	}
+	set< vector<V> > seen; // every clique reported as added, so none is reported twice
+	CliquesToDelta send_cliques_here(callback, seen);
+	MaximalToDelta send_maximal_here(adj, send_cliques_here);
+
+	For(old, old_cliques) {
+		const vector<V> &cl = *old;
+		edge e;
+		if(find_removed_edge(cl, removed, e)) {
+			callback.clique_removed(&cl.front(), cl.size());
+			/* Any new maximal clique inside cl is a maximal clique of the subgraph cl's nodes
+			 * now induce, so enumerate those, rooting each at its smallest node as in
+			 * cliquesForOneNode, and keep the ones that are still maximal in the whole graph.
+			 * A node that has left the graph has all its edges removed, so it's left out.
+			 */
+			vector<V> live;
+			For(v, cl)
+				if(*v < adj.numNodes())
+					live.push_back(*v);
+			if(live.size() < minimumSize)
+				continue;
+			For(v, live) {
+				vector<V> Compsub(1, *v);
+				list_of_ints Not, Candidates;
+				const neighbour_range nv = adj.neighbours(*v);
+				vector<V> inside;
+				set_intersection(live.begin(), live.end(), nv.begin(), nv.end(), back_inserter(inside));
+				For(u, inside)
+					(*u < *v ? Not : Candidates).push_back(*u);
+				cliquesWorker(adj, & send_maximal_here, minimumSize, Compsub, Not, Candidates);
+			}
+			continue;
 		}
+		// still a clique. If it has an end of an added edge in it, it might now be inside a bigger one
+		For(v, cl)
+			if(ends_of_added_edges.count(*v)) {
+				unless(is_maximal(adj, cl))
+					callback.clique_removed(&cl.front(), cl.size());
+				break;
+			}
 	}
-	PP3( currentDiscs , num_connections , cands.size() );
-	assert( currentDiscs + num_connections == int(cands.size()) );
-	return currentDiscs;
-	*/
-	return int32_t(cands.size() - num_connections);
 
+	For(e, added_edges) { // every maximal clique with both ends of e in it is new
+		const edge uv = ordered(*e);
+		assert(uv.second < adj.numNodes() && adj.are_connected(uv.first, uv.second));
+		vector<V> Compsub;
+		Compsub.push_back(uv.first);
+		Compsub.push_back(uv.second);
+		list_of_ints Not, Candidates;
+		const neighbour_range nu = adj.neighbours(uv.first);
+		const neighbour_range nv = adj.neighbours(uv.second);
+		set_intersection(nu.begin(), nu.end(), nv.begin(), nv.end(), back_inserter(Candidates));
+		cliquesWorker(adj, & send_cliques_here, minimumSize, Compsub, Not, Candidates);
+	}
+}
 
+struct DeltaToText : public clique_delta_callback {
+	const output :: node_name_cache &names;
+	const vector<string> &gone; // the names of the nodes no longer in the graph, from names.numNodes() on
+	output :: buffered_writer &out;
+	int64_t added, removed;
+	DeltaToText(const output :: node_name_cache &_names, const vector<string> &_gone, output :: buffered_writer &_out) : names(_names), gone(_gone), out(_out), added(0), removed(0) {}
+	void write(const char sign, const int32_t * nodes, size_t size) {
+		this->out.put(sign);
+		for(size_t i = 0; i < size; i++) {
+			this->out.put(' ');
+			if(nodes[i] < this->names.numNodes())
+				this->out.append_name(this->names, nodes[i]);
+			else {
+				const string &name = this->gone.at(nodes[i] - this->names.numNodes());
+				this->out.append(name.data(), name.size());
+			}
+		}
+		this->out.put('\n');
+	}
+	virtual void clique_added   (const int32_t * nodes, size_t size) { ++ this->added; this->write('+', nodes, size); }
+	virtual void clique_removed (const int32_t * nodes, size_t size) { ++ this->removed; this->write('-', nodes, size); }
+};
+void cliqueDeltaToStdout      (const graph :: NetworkInterfaceConvertedToString * net, unsigned int minimumSize, const char * previous_cliques_file, const char * edge_changes_file) {
+	const SimpleIntGraph g = net->get_plain_graph();
+	const output :: node_name_cache names(net);
+	map<string, V> id_of; // every node in the graph, and then those in the changes that have gone
+	for(V n = 0; n < names.numNodes(); n++)
+		id_of[names.name_as_string(n)] = n;
+	vector<string> gone;
+
+	vector< pair<int32_t, int32_t> > added_edges, removed_edges;
+	set<V> ends; // of the changed edges
+	{
+		ifstream in(edge_changes_file);
+		unless(in) throw std :: runtime_error(string("couldn't open \"") + edge_changes_file + "\"");
+		string line;
+		int64_t line_number = 0;
+		while(getline(in, line)) {
+			++ line_number;
+			istringstream fields(line);
+			string sign, a, b, extra;
+			unless(fields >> sign) // blank
+				continue;
+			if(sign.at(0) == '#')
+				continue;
+			ostringstream where;
+			where << "line " << line_number << " of \"" << edge_changes_file << "\"";
+			if((sign != "+" && sign != "-") || !(fields >> a >> b) || (fields >> extra))
+				throw std :: runtime_error(where.str() + " should be \"+ node node\" or \"- node node\"");
+			const string * names_of_ends[2] = { &a, &b };
+			V e[2];
+			for(int i = 0; i < 2; i++) {
+				map<string, V> :: iterator it = id_of.find(*names_of_ends[i]);
+				if(it == id_of.end()) { // it can only be a node whose edges have all gone
+					it = id_of.insert(make_pair(*names_of_ends[i], V(names.numNodes() + gone.size()))).first;
+					gone.push_back(*names_of_ends[i]);
+				}
+				e[i] = it->second;
+				ends.insert(e[i]);
+			}
+			const bool in_the_graph = e[0] < names.numNodes() && e[1] < names.numNodes() && g->are_connected(e[0], e[1]);
+			if(in_the_graph != (sign == "+"))
+				throw std :: runtime_error(where.str() + (sign == "+" ? " adds an edge that isn't in the edge list" : " removes an edge that's still in the edge list"));
+			(sign == "+" ? added_edges : removed_edges).push_back(make_pair(e[0], e[1]));
+		}
+	}
+
+	set<edge> removed;
+	For(e, removed_edges)
+		removed.insert(ordered(*e));
+
+	vector< vector<int32_t> > old_cliques; // just those with an end of a changed edge in them
+	{
+		ifstream in(previous_cliques_file);
+		unless(in) throw std :: runtime_error(string("couldn't open \"") + previous_cliques_file + "\"");
+		string line, name;
+		vector<string> members;
+		vector<int32_t> cl;
+		int64_t line_number = 0;
+		while(getline(in, line)) {
+			++ line_number;
+			istringstream fields(line);
+			members.clear();
+			while(fields >> name)
+				members.push_back(name);
+			/* A node that's no longer in the graph must have lost every edge it had, so each of
+			 * its edges in this clique has to be listed as removed. Otherwise the two files
+			 * don't describe the same change, and we'd be looking up a node we don't have.
+			 */
+			for(size_t i = 0; i < members.size(); i++) {
+				map<string, V> :: const_iterator it = id_of.find(members[i]);
+				if(it != id_of.end() && it->second < names.numNodes())
+					continue;
+				for(size_t j = 0; j < members.size(); j++) {
+					if(j == i)
+						continue;
+					map<string, V> :: const_iterator other = id_of.find(members[j]);
+					unless(it != id_of.end() && other != id_of.end() && removed.count(ordered(make_pair(it->second, other->second)))) {
+						ostringstream where;
+						where << "line " << line_number << " of \"" << previous_cliques_file << "\"";
+						throw std :: runtime_error(where.str() + " has \"" + members[i] + "\", which isn't in the graph, but its edge to \"" + members[j] + "\" isn't removed in \"" + edge_changes_file + "\"");
+					}
+				}
+			}
+			if(members.size() < minimumSize)
+				continue;
+			cl.clear();
+			bool touched = false;
+			For(member, members) {
+				const V v = id_of.find(*member)->second; // it's there, as the clique has more than one node
+				cl.push_back(v);
+				touched = touched || ends.count(v);
+			}
+			unless(touched)
+				continue;
+			sort(cl.begin(), cl.end());
+			old_cliques.push_back(cl);
+		}
+	}
+
+	output :: buffered_writer out(stdout);
+	DeltaToText send_delta_here(names, gone, out);
+	cliqueDeltaToCallback(g, minimumSize, added_edges, removed_edges, old_cliques, send_delta_here);
+	out.flush();
+	cerr << send_delta_here.added << " cliques added, " << send_delta_here.removed << " removed" << endl;
+}
+
+struct clique_block { // many sorted cliques, concatenated. Cliques travel through the clique_stream's queue in these
+	vector<V> nodes;
+	vector<size_t> ends; // clique i is nodes[ends[i-1], ends[i])
+	size_t size() const { return this->ends.size(); }
+	void clear() { this->nodes.clear(); this->ends.clear(); }
+};
+static void swap(clique_block &l, clique_block &r) { // so that the bounded_queue doesn't copy them
+	l.nodes.swap(r.nodes);
+	l.ends.swap(r.ends);
+}
+struct stream_cancelled {
+};
+struct CliquesToQueue {
+	threads :: bounded_queue<clique_block> & q;
+	const size_t cliques_per_block;
+	clique_block block;
+	CliquesToQueue(threads :: bounded_queue<clique_block> & _q, size_t _cliques_per_block) : q(_q), cliques_per_block(_cliques_per_block) {}
+	void receive_unsorted_clique (const vector<V> &Compsub) {
+		const size_t start = this->block.nodes.size();
+		this->block.nodes.insert(this->block.nodes.end(), Compsub.begin(), Compsub.end());
+		sort(this->block.nodes.begin() + start, this->block.nodes.end());
+		this->block.ends.push_back(this->block.nodes.size());
+		if(this->block.size() >= this->cliques_per_block)
+			this->flush();
+	}
+	void flush() {
+		if(this->block.size() == 0)
+			return;
+		unless(this->q.push(this->block)) // the consumer has gone away. Unwind the enumeration.
+			throw stream_cancelled();
+	}
+};
+struct clique_stream_impl : public threads :: runnable {
+	const SimpleIntGraph g;
+	const unsigned int minimumSize;
+	const size_t cliques_per_block;
+	threads :: bounded_queue<clique_block> q;
+	bool failed; // set by the producer, before it closes the queue
+	clique_block current; // the block the consumer is working through
+	size_t next_in_current;
+	clique_stream_impl(SimpleIntGraph _g, unsigned int _minimumSize, size_t max_queued_cliques)
+		: g(_g), minimumSize(_minimumSize)
+		, cliques_per_block(max(size_t(1), min(size_t(1024), max_queued_cliques)))
+		, q(max_queued_cliques / cliques_per_block)
+		, failed(false), next_in_current(0) {}
+	virtual void run() { // the producer thread
+		try {
+			CliquesToQueue send_cliques_here(this->q, this->cliques_per_block);
+			findCliques(this->g, & send_cliques_here, this->minimumSize, false);
+			send_cliques_here.flush();
+		} catch (stream_cancelled &) {
+		} catch (...) {
+			this->failed = true;
+		}
+		this->q.close();
+	}
+};
+
+clique_stream :: clique_stream(SimpleIntGraph g, unsigned int minimumSize, size_t max_queued_cliques) : impl(NULL), producer(NULL) {
+	check_before_finding_cliques(g, minimumSize); // throw now, in the caller's thread, if the input is no good
+	this->impl = new clique_stream_impl(g, minimumSize, max_queued_cliques);
+	try {
+		this->producer = new threads :: thread(*this->impl);
+	} catch (std :: runtime_error &) {
+		delete this->impl;
+		throw;
+	}
+}
+clique_stream :: ~clique_stream() {
+	this->impl->q.cancel();
+	delete this->producer; // joins
+	delete this->impl;
+}
+bool clique_stream :: next(const int32_t * & nodes, size_t & size) {
+	clique_stream_impl & s = *this->impl;
+	while(s.next_in_current >= s.current.size()) {
+		s.current.clear();
+		s.next_in_current = 0;
+		unless(s.q.pop(s.current)) {
+			if(s.failed)
+				throw std :: runtime_error("clique_stream: the enumeration failed");
+			return false;
+		}
+	}
+	const size_t begin = s.next_in_current == 0 ? 0 : s.current.ends.at(s.next_in_current - 1);
+	const size_t end = s.current.ends.at(s.next_in_current);
+	nodes = &s.current.nodes.front() + begin;
+	size = end - begin;
+	++ s.next_in_current;
+	return true;
+}
+
+template <typename Adjacency>
+static int32_t count_disconnections(const list_of_ints &cands, const int32_t v, const Adjacency &g) {
+	// cands is sorted, as are the neighbours. A merge that just counts; nothing is allocated.
+	const neighbour_range v_neighs = g.neighbours(v);
+	int32_t num_connections = 0;
+	list_of_ints :: const_iterator c = cands.get().begin();
+	const list_of_ints :: const_iterator c_end = cands.get().end();
+	const V * n = v_neighs.begin();
+	const V * const n_end = v_neighs.end();
+	while(c != c_end && n != n_end) {
+		if(*c < *n)
+			++c;
+		else if(*n < *c)
+			++n;
+		else {
+			++ num_connections;
+			++c;
+			++n;
+		}
+	}
+	return int32_t(cands.size() - num_connections);
 }
-static void find_node_with_fewest_discs(int &fewestDisc, int &fewestDiscVertex, bool &fewestIsInCands, const list_of_ints &Not, const list_of_ints &Candidates, const SimpleIntGraph &g) {
-	set<int32_t> cands(Candidates.get().begin(), Candidates.get().end());
+template <typename Adjacency>
+static void find_node_with_fewest_discs(int &fewestDisc, int &fewestDiscVertex, bool &fewestIsInCands, const list_of_ints &Not, const list_of_ints &Candidates, const Adjacency &g) {
+		const list_of_ints &cands = Candidates; // already sorted, no need to copy it into a set<>
 		assert(!Candidates.empty());
 		// TODO: Make use of degree, or something like that, to speed up this counting of disconnects?
 		const list_of_ints :: const_iterator not_end = Not.get().end();
@@ -4,13 +4,76 @@
 
 #include "graph/network.hpp"
 
+#include <vector>
+#include <utility>
+#include <cstddef>
+
 typedef const graph :: VerySimpleGraphInterface * SimpleIntGraph;
 
+namespace threads { class thread; }
+
 namespace cliques {
 
-void cliquesToStdout          (const graph :: NetworkInterfaceConvertedToString * net, unsigned int minimumSize); // You're not allowed to ask for the 2-cliques
+void cliquesToStdout          (const graph :: NetworkInterfaceConvertedToString * net, unsigned int minimumSize, int num_threads = 1, bool deterministic = false); // You're not allowed to ask for the 2-cliques
+                                                      // With deterministic, several threads print exactly what one thread would
 void cliquesToVector          (const graph :: NetworkInterfaceConvertedToString * net, unsigned int minimumSize, std :: vector< std :: vector<int32_t> > & ); // You're not allowed to ask for the 2-cliques
 
+/*
+ * The library interface. Link against libcliques.a (or libcliques.so) and use either:
+ *  - push style: cliquesToCallback calls you once per maximal clique, or
+ *  - pull style: a clique_stream runs the enumeration on a background thread and you call next().
+ * Either way, each clique is a view (pointer + length) of node ids in increasing order.
+ * The view is only valid until you return from the callback, or until the next call to next().
+ */
+
+struct clique_callback {
+	virtual void receive_sorted_clique (const int32_t * nodes, size_t size) = 0;
+	virtual ~clique_callback() {}
+};
+void cliquesToCallback        (SimpleIntGraph g, unsigned int minimumSize, clique_callback & callback); // You're not allowed to ask for the 2-cliques
+void cliquesTouchingNodesToCallback (SimpleIntGraph g, unsigned int minimumSize, const std :: vector<int32_t> & touched_nodes, clique_callback & callback);
+                                                      // Only the maximal cliques with at least one of the touched_nodes in them. The work is
+                                                      // proportional to the neighbourhoods of those nodes, not to the graph. e.g. after some edges have changed
+
+/*
+ * Keeping a list of maximal cliques up to date as edges are added and removed, without
+ * enumerating again. g is the graph *after* the changes. old_cliques must hold every old
+ * maximal clique (of at least minimumSize, with its nodes in increasing order) that has an
+ * end of a changed edge in it; no other clique can change. A node with all its edges removed
+ * isn't in g any more; give it an id of g->numNodes() or above.
+ * For each added edge, the new cliques come from Bron-Kerbosch on the common neighbourhood
+ * of its ends, and any old clique now inside one of those is removed. Each old clique with a
+ * removed edge in it is removed, and split on that edge until the pieces are cliques again.
+ * The work is proportional to the neighbourhoods of the changed edges, not to the graph.
+ */
+struct clique_delta_callback {
+	virtual void clique_added   (const int32_t * nodes, size_t size) = 0;
+	virtual void clique_removed (const int32_t * nodes, size_t size) = 0;
+	virtual ~clique_delta_callback() {}
+};
+void cliqueDeltaToCallback    (SimpleIntGraph g, unsigned int minimumSize
+		, const std :: vector< std :: pair<int32_t, int32_t> > & added_edges
+		, const std :: vector< std :: pair<int32_t, int32_t> > & removed_edges
+		, const std :: vector< std :: vector<int32_t> > & old_cliques
+		, clique_delta_callback & callback);
+void cliqueDeltaToStdout      (const graph :: NetworkInterfaceConvertedToString * net, unsigned int minimumSize, const char * previous_cliques_file, const char * edge_changes_file);
+                                                      // As above, for the text files. net is the new graph, previous_cliques_file the
+                                                      // earlier output, and edge_changes_file has "+ a b" or "- a b" on each line.
+                                                      // Prints "+ " or "- " and the clique, for each clique added or removed.
+                                                      // Throws std :: runtime_error if the files are no good, or don't match net
+
+struct clique_stream_impl;
+class clique_stream { // a generator of maximal cliques, with a bounded queue between the enumeration and you
+	clique_stream_impl * impl;
+	threads :: thread * producer;
+	clique_stream(const clique_stream &);
+	clique_stream & operator= (const clique_stream &);
+public:
+	clique_stream(SimpleIntGraph g, unsigned int minimumSize, size_t max_queued_cliques = 65536); // g must outlive the stream
+	~clique_stream(); // it's fine to destroy it early, the enumeration will be stopped
+	bool next(const int32_t * & nodes, size_t & size); // returns false when there are no more cliques
+};
+
 } // namespace cliques
 
 
@@ -28,18 +28,35 @@ const char *gengetopt_args_info_usage = "Usage: Usage: cp5 [OPTIONS]... edge_lis
 const char *gengetopt_args_info_description = "";
 
 const char *gengetopt_args_info_help[] = {
-  "  -h, --help           Print help and exit",
-  "  -V, --version        Print version and exit",
-  "  -k, --k=INT          minimum size of clique, k. Must be at least 3.  \n                         (default=`3')",
-  "  -K, --K=INT          max k of interest. default is to do all k.      \n                         (default=`-1')",
-  "      --stringIDs      string IDs in the input  (default=off)",
-  "      --rebuild.bloom  rebuild bloom filter occasionally  (default=off)",
-  "      --comments       detailed version description  (default=off)",
+  "  -h, --help                 Print help and exit",
+  "  -V, --version              Print version and exit",
+  "  -k, --k=INT                minimum size of clique, k. Must be at least 3.  \n                               (default=`3')",
+  "  -K, --K=INT                max k of interest. default is to do all k.      \n                               (default=`-1')",
+  "      --stringIDs            string IDs in the input  (default=off)",
+  "      --rebuild.bloom        rebuild bloom filter occasionally  (default=off)",
+  "      --counting-bloom       one counting Bloom filter for each k, from which \n                               the cliques are removed as they are assigned, \n                               rather than one built for each source component  \n                               (default=off)",
+  "      --search=STRING        how to find the overlapping cliques: the tree of \n                               Bloom filters (bloom), the same tree searched \n                               one branch at a time without prefetching \n                               (bloom-recursive), or an inverted index (index)  \n                               (possible values=\"bloom\", \"bloom-recursive\", \n                               \"index\" default=`bloom')",
+  "      --search-stats=STRING  write what the search of the tree did (branches \n                               visited and pruned, leaves, overlap checks, the \n                               filter's false positive rate), for each k and \n                               each source component, to this JSON file",
+  "      --clique-order=STRING  the order of the cliques of each size (they are \n                               sorted biggest first), the leaves of the search \n                               tree: as found (bk), lexicographic (lex), by \n                               smallest node (minnode), or reverse \n                               Cuthill-McKee over the cliques sharing a node \n                               (rcm-on-clique-graph)  (possible values=\"bk\", \n                               \"lex\", \"minnode\", \"rcm-on-clique-graph\" \n                               default=`bk')",
+  "  -t, --threads=INT          number of threads, each percolating separate \n                               communities  (default=`1')",
+  "      --sweep                all k in one sweep, by union-find over the \n                               overlapping pairs of cliques  (default=off)",
+  "      --save-cliques=STRING  save the cliques to this file, for --load-cliques \n                               later",
+  "      --load-cliques=STRING  map the cliques from this file, rather than \n                               finding them again",
+  "      --binary-output        percolated_cliques<k>.bin, with clique ids, rather \n                               than the text percolated_cliques<k>  \n                               (default=off)",
+  "      --resume=STRING        carry on from the last level completed in this \n                               output directory. Give just the edge_list then",
+  "      --memory-limit=INT     in megabytes. Keep the cliques, and anything else \n                               that grows with them, on disk and mapped, and \n                               percolate one source component at a time",
+  "      --incremental=STRING   update the communities in this earlier output \n                               directory (from a run with --binary-output, or \n                               --incremental) for the edge changes in \n                               --edge-changes",
+  "      --edge-changes=STRING  the edges added ('+ a b') and removed ('- a b') \n                               since that run. The edge_list must be the new \n                               one",
+  "      --comments             detailed version description  (default=off)",
     0
 };
 
+char *cmdline_parser_search_values[] = {"bloom", "bloom-recursive", "index", 0} ;	/* Possible values for search.  */
+char *cmdline_parser_clique_order_values[] = {"bk", "lex", "minnode", "rcm-on-clique-graph", 0} ;	/* Possible values for clique-order.  */
+
 typedef enum {ARG_NO
   , ARG_FLAG
+  , ARG_STRING
   , ARG_INT
 } cmdline_parser_arg_type;
 
@@ -53,6 +70,9 @@ cmdline_parser_internal (int argc, char * const *argv, struct gengetopt_args_inf
                         struct cmdline_parser_params *params, const char *additional_error);
 
 
+static int
+check_possible_values(const char *val, char *values[]);
+
 static char *
 gengetopt_strdup (const char *s);
 
@@ -65,6 +85,19 @@ void clear_given (struct gengetopt_args_info *args_info)
   args_info->K_given = 0 ;
   args_info->stringIDs_given = 0 ;
   args_info->rebuild_bloom_given = 0 ;
+  args_info->counting_bloom_given = 0 ;
+  args_info->search_given = 0 ;
+  args_info->search_stats_given = 0 ;
+  args_info->clique_order_given = 0 ;
+  args_info->threads_given = 0 ;
+  args_info->sweep_given = 0 ;
+  args_info->save_cliques_given = 0 ;
+  args_info->load_cliques_given = 0 ;
+  args_info->binary_output_given = 0 ;
+  args_info->resume_given = 0 ;
+  args_info->memory_limit_given = 0 ;
+  args_info->incremental_given = 0 ;
+  args_info->edge_changes_given = 0 ;
   args_info->comments_given = 0 ;
 }
 
@@ -77,6 +110,28 @@ void clear_args (struct gengetopt_args_info *args_info)
   args_info->K_orig = NULL;
   args_info->stringIDs_flag = 0;
   args_info->rebuild_bloom_flag = 0;
+  args_info->counting_bloom_flag = 0;
+  args_info->search_arg = gengetopt_strdup ("bloom");
+  args_info->search_orig = NULL;
+  args_info->search_stats_arg = NULL;
+  args_info->search_stats_orig = NULL;
+  args_info->clique_order_arg = gengetopt_strdup ("bk");
+  args_info->clique_order_orig = NULL;
+  args_info->threads_arg = 1;
+  args_info->threads_orig = NULL;
+  args_info->sweep_flag = 0;
+  args_info->save_cliques_arg = NULL;
+  args_info->save_cliques_orig = NULL;
+  args_info->load_cliques_arg = NULL;
+  args_info->load_cliques_orig = NULL;
+  args_info->binary_output_flag = 0;
+  args_info->resume_arg = NULL;
+  args_info->resume_orig = NULL;
+  args_info->memory_limit_orig = NULL;
+  args_info->incremental_arg = NULL;
+  args_info->incremental_orig = NULL;
+  args_info->edge_changes_arg = NULL;
+  args_info->edge_changes_orig = NULL;
   args_info->comments_flag = 0;
   
 }
@@ -92,7 +147,20 @@ void init_args_info(struct gengetopt_args_info *args_info)
   args_info->K_help = gengetopt_args_info_help[3] ;
   args_info->stringIDs_help = gengetopt_args_info_help[4] ;
   args_info->rebuild_bloom_help = gengetopt_args_info_help[5] ;
-  args_info->comments_help = gengetopt_args_info_help[6] ;
+  args_info->counting_bloom_help = gengetopt_args_info_help[6] ;
+  args_info->search_help = gengetopt_args_info_help[7] ;
+  args_info->search_stats_help = gengetopt_args_info_help[8] ;
+  args_info->clique_order_help = gengetopt_args_info_help[9] ;
+  args_info->threads_help = gengetopt_args_info_help[10] ;
+  args_info->sweep_help = gengetopt_args_info_help[11] ;
+  args_info->save_cliques_help = gengetopt_args_info_help[12] ;
+  args_info->load_cliques_help = gengetopt_args_info_help[13] ;
+  args_info->binary_output_help = gengetopt_args_info_help[14] ;
+  args_info->resume_help = gengetopt_args_info_help[15] ;
+  args_info->memory_limit_help = gengetopt_args_info_help[16] ;
+  args_info->incremental_help = gengetopt_args_info_help[17] ;
+  args_info->edge_changes_help = gengetopt_args_info_help[18] ;
+  args_info->comments_help = gengetopt_args_info_help[19] ;
   
 }
 
@@ -176,6 +244,24 @@ cmdline_parser_release (struct gengetopt_args_info *args_info)
   unsigned int i;
   free_string_field (&(args_info->k_orig));
   free_string_field (&(args_info->K_orig));
+  free_string_field (&(args_info->search_arg));
+  free_string_field (&(args_info->search_orig));
+  free_string_field (&(args_info->search_stats_arg));
+  free_string_field (&(args_info->search_stats_orig));
+  free_string_field (&(args_info->clique_order_arg));
+  free_string_field (&(args_info->clique_order_orig));
+  free_string_field (&(args_info->threads_orig));
+  free_string_field (&(args_info->save_cliques_arg));
+  free_string_field (&(args_info->save_cliques_orig));
+  free_string_field (&(args_info->load_cliques_arg));
+  free_string_field (&(args_info->load_cliques_orig));
+  free_string_field (&(args_info->resume_arg));
+  free_string_field (&(args_info->resume_orig));
+  free_string_field (&(args_info->memory_limit_orig));
+  free_string_field (&(args_info->incremental_arg));
+  free_string_field (&(args_info->incremental_orig));
+  free_string_field (&(args_info->edge_changes_arg));
+  free_string_field (&(args_info->edge_changes_orig));
   
   
   for (i = 0; i < args_info->inputs_num; ++i)
@@ -191,14 +277,56 @@ cmdline_parser_release (struct gengetopt_args_info *args_info)
 static void
 write_into_file(FILE *outfile, const char *opt, const char *arg, char *values[])
 {
+  int found = -1;
   if (arg) {
-    fprintf(outfile, "%s=\"%s\"\n", opt, arg);
+    if (values) {
+      found = check_possible_values(arg, values);
+    }
+    if (found >= 0)
+      fprintf(outfile, "%s=\"%s\" # %s\n", opt, arg, values[found]);
+    else
+      fprintf(outfile, "%s=\"%s\"\n", opt, arg);
   } else {
     fprintf(outfile, "%s\n", opt);
   }
 }
 
 
+/*
+ * Returns:
+ * - the index of the matched value
+ * - -1 if not found
+ * - -2 if more than one value has matched
+ */
+static int
+check_possible_values(const char *val, char *values[])
+{
+  int i, found, last;
+  size_t len;
+
+  if (!val)   /* otherwise strlen() crashes below */
+    return -1; /* -1 means no argument for the option */
+
+  found = last = 0;
+
+  for (i = 0, len = strlen(val); values[i]; ++i)
+    {
+      if (strncmp(val, values[i], len) == 0)
+        {
+          ++found;
+          last = i;
+          if (strlen(values[i]) == len)
+            return i; /* exact macth no need to check more */
+        }
+    }
+
+  if (found == 1) /* one match: OK */
+    return last;
+
+  return (found ? -2 : -1); /* return many values or none matched */
+}
+
+
 int
 cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
 {
@@ -222,6 +350,32 @@ cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
     write_into_file(outfile, "stringIDs", 0, 0 );
   if (args_info->rebuild_bloom_given)
     write_into_file(outfile, "rebuild.bloom", 0, 0 );
+  if (args_info->counting_bloom_given)
+    write_into_file(outfile, "counting-bloom", 0, 0 );
+  if (args_info->search_given)
+    write_into_file(outfile, "search", args_info->search_orig, cmdline_parser_search_values);
+  if (args_info->search_stats_given)
+    write_into_file(outfile, "search-stats", args_info->search_stats_orig, 0);
+  if (args_info->clique_order_given)
+    write_into_file(outfile, "clique-order", args_info->clique_order_orig, cmdline_parser_clique_order_values);
+  if (args_info->threads_given)
+    write_into_file(outfile, "threads", args_info->threads_orig, 0);
+  if (args_info->sweep_given)
+    write_into_file(outfile, "sweep", 0, 0 );
+  if (args_info->save_cliques_given)
+    write_into_file(outfile, "save-cliques", args_info->save_cliques_orig, 0);
+  if (args_info->load_cliques_given)
+    write_into_file(outfile, "load-cliques", args_info->load_cliques_orig, 0);
+  if (args_info->binary_output_given)
+    write_into_file(outfile, "binary-output", 0, 0 );
+  if (args_info->resume_given)
+    write_into_file(outfile, "resume", args_info->resume_orig, 0);
+  if (args_info->memory_limit_given)
+    write_into_file(outfile, "memory-limit", args_info->memory_limit_orig, 0);
+  if (args_info->incremental_given)
+    write_into_file(outfile, "incremental", args_info->incremental_orig, 0);
+  if (args_info->edge_changes_given)
+    write_into_file(outfile, "edge-changes", args_info->edge_changes_orig, 0);
   if (args_info->comments_given)
     write_into_file(outfile, "comments", 0, 0 );
   
@@ -356,6 +510,7 @@ int update_arg(void *field, char **orig_field,
   char *stop_char = 0;
   const char *val = value;
   int found;
+  char **string_field;
 
   stop_char = 0;
   found = 0;
@@ -373,7 +528,19 @@ int update_arg(void *field, char **orig_field,
       return 1; /* failure */
     }
 
-    
+  if (possible_values && (found = check_possible_values((value ? value : default_value), possible_values)) < 0)
+    {
+      if (short_opt != '-')
+        fprintf (stderr, "%s: %s argument, \"%s\", for option `--%s' (`-%c')%s\n",
+          package_name, (found == -2) ? "ambiguous" : "invalid", value, long_opt, short_opt,
+          (additional_error ? additional_error : ""));
+      else
+        fprintf (stderr, "%s: %s argument, \"%s\", for option `--%s'%s\n",
+          package_name, (found == -2) ? "ambiguous" : "invalid", value, long_opt,
+          (additional_error ? additional_error : ""));
+      return 1; /* failure */
+    }
+
   if (field_given && *field_given && ! override)
     return 0;
   if (prev_given)
@@ -390,6 +557,14 @@ int update_arg(void *field, char **orig_field,
   case ARG_INT:
     if (val) *((int *)field) = strtol (val, &stop_char, 0);
     break;
+  case ARG_STRING:
+    if (val) {
+      string_field = (char **)field;
+      if (!no_free && *string_field)
+        free (*string_field); /* free previous string */
+      *string_field = gengetopt_strdup (val);
+    }
+    break;
   default:
     break;
   };
@@ -469,11 +644,24 @@ cmdline_parser_internal (int argc, char * const *argv, struct gengetopt_args_inf
         { "K",	1, NULL, 'K' },
         { "stringIDs",	0, NULL, 0 },
         { "rebuild.bloom",	0, NULL, 0 },
+        { "counting-bloom",	0, NULL, 0 },
+        { "search",	1, NULL, 0 },
+        { "search-stats",	1, NULL, 0 },
+        { "clique-order",	1, NULL, 0 },
+        { "threads",	1, NULL, 't' },
+        { "sweep",	0, NULL, 0 },
+        { "save-cliques",	1, NULL, 0 },
+        { "load-cliques",	1, NULL, 0 },
+        { "binary-output",	0, NULL, 0 },
+        { "resume",	1, NULL, 0 },
+        { "memory-limit",	1, NULL, 0 },
+        { "incremental",	1, NULL, 0 },
+        { "edge-changes",	1, NULL, 0 },
         { "comments",	0, NULL, 0 },
         { NULL,	0, NULL, 0 }
       };
 
-      c = getopt_long (argc, argv, "hVk:K:", long_options, &option_index);
+      c = getopt_long (argc, argv, "hVk:K:t:", long_options, &option_index);
 
       if (c == -1) break;	/* Exit from `while (1)' loop.  */
 
@@ -513,6 +701,18 @@ cmdline_parser_internal (int argc, char * const *argv, struct gengetopt_args_inf
             goto failure;
         
           break;
+        case 't':	/* number of threads, each percolating separate communities.  */
+        
+        
+          if (update_arg( (void *)&(args_info->threads_arg), 
+               &(args_info->threads_orig), &(args_info->threads_given),
+              &(local_args_info.threads_given), optarg, 0, "1", ARG_INT,
+              check_ambiguity, override, 0, 0,
+              "threads", 't',
+              additional_error))
+            goto failure;
+        
+          break;
 
         case 0:	/* Long option with no short option */
           /* string IDs in the input.  */
@@ -538,6 +738,168 @@ cmdline_parser_internal (int argc, char * const *argv, struct gengetopt_args_inf
                 additional_error))
               goto failure;
           
+          }
+          /* one counting Bloom filter for each k, from which the cliques are removed as they are assigned, rather than one built for each source component.  */
+          else if (strcmp (long_options[option_index].name, "counting-bloom") == 0)
+          {
+          
+          
+            if (update_arg((void *)&(args_info->counting_bloom_flag), 0, &(args_info->counting_bloom_given),
+                &(local_args_info.counting_bloom_given), optarg, 0, 0, ARG_FLAG,
+                check_ambiguity, override, 1, 0, "counting-bloom", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* how to find the overlapping cliques: the tree of Bloom filters (bloom), the same tree searched one branch at a time without prefetching (bloom-recursive), or an inverted index (index).  */
+          else if (strcmp (long_options[option_index].name, "search") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->search_arg), 
+                 &(args_info->search_orig), &(args_info->search_given),
+                &(local_args_info.search_given), optarg, cmdline_parser_search_values, "bloom", ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "search", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* write what the search of the tree did (branches visited and pruned, leaves, overlap checks, the filter's false positive rate), for each k and each source component, to this JSON file.  */
+          else if (strcmp (long_options[option_index].name, "search-stats") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->search_stats_arg), 
+                 &(args_info->search_stats_orig), &(args_info->search_stats_given),
+                &(local_args_info.search_stats_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "search-stats", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* the order of the cliques of each size (they are sorted biggest first), the leaves of the search tree: as found (bk), lexicographic (lex), by smallest node (minnode), or reverse Cuthill-McKee over the cliques sharing a node (rcm-on-clique-graph).  */
+          else if (strcmp (long_options[option_index].name, "clique-order") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->clique_order_arg), 
+                 &(args_info->clique_order_orig), &(args_info->clique_order_given),
+                &(local_args_info.clique_order_given), optarg, cmdline_parser_clique_order_values, "bk", ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "clique-order", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* all k in one sweep, by union-find over the overlapping pairs of cliques.  */
+          else if (strcmp (long_options[option_index].name, "sweep") == 0)
+          {
+          
+          
+            if (update_arg((void *)&(args_info->sweep_flag), 0, &(args_info->sweep_given),
+                &(local_args_info.sweep_given), optarg, 0, 0, ARG_FLAG,
+                check_ambiguity, override, 1, 0, "sweep", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* save the cliques to this file, for --load-cliques later.  */
+          else if (strcmp (long_options[option_index].name, "save-cliques") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->save_cliques_arg), 
+                 &(args_info->save_cliques_orig), &(args_info->save_cliques_given),
+                &(local_args_info.save_cliques_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "save-cliques", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* map the cliques from this file, rather than finding them again.  */
+          else if (strcmp (long_options[option_index].name, "load-cliques") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->load_cliques_arg), 
+                 &(args_info->load_cliques_orig), &(args_info->load_cliques_given),
+                &(local_args_info.load_cliques_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "load-cliques", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* percolated_cliques<k>.bin, with clique ids, rather than the text percolated_cliques<k>.  */
+          else if (strcmp (long_options[option_index].name, "binary-output") == 0)
+          {
+          
+          
+            if (update_arg((void *)&(args_info->binary_output_flag), 0, &(args_info->binary_output_given),
+                &(local_args_info.binary_output_given), optarg, 0, 0, ARG_FLAG,
+                check_ambiguity, override, 1, 0, "binary-output", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* carry on from the last level completed in this output directory. Give just the edge_list then.  */
+          else if (strcmp (long_options[option_index].name, "resume") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->resume_arg), 
+                 &(args_info->resume_orig), &(args_info->resume_given),
+                &(local_args_info.resume_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "resume", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* in megabytes. Keep the cliques, and anything else that grows with them, on disk and mapped, and percolate one source component at a time.  */
+          else if (strcmp (long_options[option_index].name, "memory-limit") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->memory_limit_arg), 
+                 &(args_info->memory_limit_orig), &(args_info->memory_limit_given),
+                &(local_args_info.memory_limit_given), optarg, 0, 0, ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "memory-limit", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* update the communities in this earlier output directory (from a run with --binary-output, or --incremental) for the edge changes in --edge-changes.  */
+          else if (strcmp (long_options[option_index].name, "incremental") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->incremental_arg), 
+                 &(args_info->incremental_orig), &(args_info->incremental_given),
+                &(local_args_info.incremental_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "incremental", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* the edges added ('+ a b') and removed ('- a b') since that run. The edge_list must be the new one.  */
+          else if (strcmp (long_options[option_index].name, "edge-changes") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->edge_changes_arg), 
+                 &(args_info->edge_changes_orig), &(args_info->edge_changes_given),
+                &(local_args_info.edge_changes_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "edge-changes", '-',
+                additional_error))
+              goto failure;
+          
           }
           /* detailed version description.  */
           else if (strcmp (long_options[option_index].name, "comments") == 0)
@@ -44,6 +44,42 @@ struct gengetopt_args_info
   const char *stringIDs_help; /**< @brief string IDs in the input help description.  */
   int rebuild_bloom_flag;	/**< @brief rebuild bloom filter occasionally (default=off).  */
   const char *rebuild_bloom_help; /**< @brief rebuild bloom filter occasionally help description.  */
+  int counting_bloom_flag;	/**< @brief one counting Bloom filter for each k, from which the cliques are removed as they are assigned, rather than one built for each source component (default=off).  */
+  const char *counting_bloom_help; /**< @brief one counting Bloom filter for each k, from which the cliques are removed as they are assigned, rather than one built for each source component help description.  */
+  char * search_arg;	/**< @brief how to find the overlapping cliques: the tree of Bloom filters (bloom), the same tree searched one branch at a time without prefetching (bloom-recursive), or an inverted index (index) (default='bloom').  */
+  char * search_orig;	/**< @brief how to find the overlapping cliques: the tree of Bloom filters (bloom), the same tree searched one branch at a time without prefetching (bloom-recursive), or an inverted index (index) original value given at command line.  */
+  const char *search_help; /**< @brief how to find the overlapping cliques: the tree of Bloom filters (bloom), the same tree searched one branch at a time without prefetching (bloom-recursive), or an inverted index (index) help description.  */
+  char * search_stats_arg;	/**< @brief write what the search of the tree did (branches visited and pruned, leaves, overlap checks, the filter's false positive rate), for each k and each source component, to this JSON file.  */
+  char * search_stats_orig;	/**< @brief write what the search of the tree did (branches visited and pruned, leaves, overlap checks, the filter's false positive rate), for each k and each source component, to this JSON file original value given at command line.  */
+  const char *search_stats_help; /**< @brief write what the search of the tree did (branches visited and pruned, leaves, overlap checks, the filter's false positive rate), for each k and each source component, to this JSON file help description.  */
+  char * clique_order_arg;	/**< @brief the order of the cliques of each size (they are sorted biggest first), the leaves of the search tree: as found (bk), lexicographic (lex), by smallest node (minnode), or reverse Cuthill-McKee over the cliques sharing a node (rcm-on-clique-graph) (default='bk').  */
+  char * clique_order_orig;	/**< @brief the order of the cliques of each size (they are sorted biggest first), the leaves of the search tree: as found (bk), lexicographic (lex), by smallest node (minnode), or reverse Cuthill-McKee over the cliques sharing a node (rcm-on-clique-graph) original value given at command line.  */
+  const char *clique_order_help; /**< @brief the order of the cliques of each size (they are sorted biggest first), the leaves of the search tree: as found (bk), lexicographic (lex), by smallest node (minnode), or reverse Cuthill-McKee over the cliques sharing a node (rcm-on-clique-graph) help description.  */
+  int threads_arg;	/**< @brief number of threads, each percolating separate communities (default='1').  */
+  char * threads_orig;	/**< @brief number of threads, each percolating separate communities original value given at command line.  */
+  const char *threads_help; /**< @brief number of threads, each percolating separate communities help description.  */
+  int sweep_flag;	/**< @brief all k in one sweep, by union-find over the overlapping pairs of cliques (default=off).  */
+  const char *sweep_help; /**< @brief all k in one sweep, by union-find over the overlapping pairs of cliques help description.  */
+  char * save_cliques_arg;	/**< @brief save the cliques to this file, for --load-cliques later.  */
+  char * save_cliques_orig;	/**< @brief save the cliques to this file, for --load-cliques later original value given at command line.  */
+  const char *save_cliques_help; /**< @brief save the cliques to this file, for --load-cliques later help description.  */
+  char * load_cliques_arg;	/**< @brief map the cliques from this file, rather than finding them again.  */
+  char * load_cliques_orig;	/**< @brief map the cliques from this file, rather than finding them again original value given at command line.  */
+  const char *load_cliques_help; /**< @brief map the cliques from this file, rather than finding them again help description.  */
+  int binary_output_flag;	/**< @brief percolated_cliques<k>.bin, with clique ids, rather than the text percolated_cliques<k> (default=off).  */
+  const char *binary_output_help; /**< @brief percolated_cliques<k>.bin, with clique ids, rather than the text percolated_cliques<k> help description.  */
+  char * resume_arg;	/**< @brief carry on from the last level completed in this output directory. Give just the edge_list then.  */
+  char * resume_orig;	/**< @brief carry on from the last level completed in this output directory. Give just the edge_list then original value given at command line.  */
+  const char *resume_help; /**< @brief carry on from the last level completed in this output directory. Give just the edge_list then help description.  */
+  int memory_limit_arg;	/**< @brief in megabytes. Keep the cliques, and anything else that grows with them, on disk and mapped, and percolate one source component at a time.  */
+  char * memory_limit_orig;	/**< @brief in megabytes. Keep the cliques, and anything else that grows with them, on disk and mapped, and percolate one source component at a time original value given at command line.  */
+  const char *memory_limit_help; /**< @brief in megabytes. Keep the cliques, and anything else that grows with them, on disk and mapped, and percolate one source component at a time help description.  */
+  char * incremental_arg;	/**< @brief update the communities in this earlier output directory (from a run with --binary-output, or --incremental) for the edge changes in --edge-changes.  */
+  char * incremental_orig;	/**< @brief update the communities in this earlier output directory (from a run with --binary-output, or --incremental) for the edge changes in --edge-changes original value given at command line.  */
+  const char *incremental_help; /**< @brief update the communities in this earlier output directory (from a run with --binary-output, or --incremental) for the edge changes in --edge-changes help description.  */
+  char * edge_changes_arg;	/**< @brief the edges added ('+ a b') and removed ('- a b') since that run. The edge_list must be the new one.  */
+  char * edge_changes_orig;	/**< @brief the edges added ('+ a b') and removed ('- a b') since that run. The edge_list must be the new one original value given at command line.  */
+  const char *edge_changes_help; /**< @brief the edges added ('+ a b') and removed ('- a b') since that run. The edge_list must be the new one help description.  */
   int comments_flag;	/**< @brief detailed version description (default=off).  */
   const char *comments_help; /**< @brief detailed version description help description.  */
   
@@ -53,6 +89,19 @@ struct gengetopt_args_info
   unsigned int K_given ;	/**< @brief Whether K was given.  */
   unsigned int stringIDs_given ;	/**< @brief Whether stringIDs was given.  */
   unsigned int rebuild_bloom_given ;	/**< @brief Whether rebuild.bloom was given.  */
+  unsigned int counting_bloom_given ;	/**< @brief Whether counting-bloom was given.  */
+  unsigned int search_given ;	/**< @brief Whether search was given.  */
+  unsigned int search_stats_given ;	/**< @brief Whether search-stats was given.  */
+  unsigned int clique_order_given ;	/**< @brief Whether clique-order was given.  */
+  unsigned int threads_given ;	/**< @brief Whether threads was given.  */
+  unsigned int sweep_given ;	/**< @brief Whether sweep was given.  */
+  unsigned int save_cliques_given ;	/**< @brief Whether save-cliques was given.  */
+  unsigned int load_cliques_given ;	/**< @brief Whether load-cliques was given.  */
+  unsigned int binary_output_given ;	/**< @brief Whether binary-output was given.  */
+  unsigned int resume_given ;	/**< @brief Whether resume was given.  */
+  unsigned int memory_limit_given ;	/**< @brief Whether memory-limit was given.  */
+  unsigned int incremental_given ;	/**< @brief Whether incremental was given.  */
+  unsigned int edge_changes_given ;	/**< @brief Whether edge-changes was given.  */
   unsigned int comments_given ;	/**< @brief Whether comments was given.  */
 
   char **inputs ; /**< @brief unamed options (options without names) */
@@ -178,6 +227,9 @@ void cmdline_parser_free (struct gengetopt_args_info *args_info);
 int cmdline_parser_required (struct gengetopt_args_info *args_info,
   const char *prog_name);
 
+extern char *cmdline_parser_search_values[] ;	/**< @brief Possible values for search.  */
+extern char *cmdline_parser_clique_order_values[] ;	/**< @brief Possible values for clique-order.  */
+
 
 #ifdef __cplusplus
 }
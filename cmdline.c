@@ -28,15 +28,20 @@ const char *gengetopt_args_info_usage = "Usage: Find Maximal Cliques [OPTIONS]..
 const char *gengetopt_args_info_description = "";
 
 const char *gengetopt_args_info_help[] = {
-  "  -h, --help       Print help and exit",
-  "  -V, --version    Print version and exit",
-  "  -k, --k=INT      minimum size of clique, k. Must be at least 3.  \n                     (default=`3')",
-  "      --stringIDs  string IDs in the input  (default=off)",
+  "  -h, --help                 Print help and exit",
+  "  -V, --version              Print version and exit",
+  "  -k, --k=INT                minimum size of clique, k. Must be at least 3.  \n                               (default=`3')",
+  "      --stringIDs            string IDs in the input  (default=off)",
+  "  -t, --threads=INT          number of threads to enumerate with  (default=`1')",
+  "      --deterministic        with several threads, print the cliques in the \n                               same order as one thread would  (default=off)",
+  "      --previous=STRING      an earlier output of this program. With \n                               --edge-changes, print only the cliques added and \n                               removed since then",
+  "      --edge-changes=STRING  the edges added ('+ a b') and removed ('- a b') \n                               since --previous. The edge_list must be the new \n                               one",
     0
 };
 
 typedef enum {ARG_NO
   , ARG_FLAG
+  , ARG_STRING
   , ARG_INT
 } cmdline_parser_arg_type;
 
@@ -60,6 +65,10 @@ void clear_given (struct gengetopt_args_info *args_info)
   args_info->version_given = 0 ;
   args_info->k_given = 0 ;
   args_info->stringIDs_given = 0 ;
+  args_info->threads_given = 0 ;
+  args_info->deterministic_given = 0 ;
+  args_info->previous_given = 0 ;
+  args_info->edge_changes_given = 0 ;
 }
 
 static
@@ -68,6 +77,13 @@ void clear_args (struct gengetopt_args_info *args_info)
   args_info->k_arg = 3;
   args_info->k_orig = NULL;
   args_info->stringIDs_flag = 0;
+  args_info->threads_arg = 1;
+  args_info->threads_orig = NULL;
+  args_info->deterministic_flag = 0;
+  args_info->previous_arg = NULL;
+  args_info->previous_orig = NULL;
+  args_info->edge_changes_arg = NULL;
+  args_info->edge_changes_orig = NULL;
   
 }
 
@@ -80,6 +96,10 @@ void init_args_info(struct gengetopt_args_info *args_info)
   args_info->version_help = gengetopt_args_info_help[1] ;
   args_info->k_help = gengetopt_args_info_help[2] ;
   args_info->stringIDs_help = gengetopt_args_info_help[3] ;
+  args_info->threads_help = gengetopt_args_info_help[4] ;
+  args_info->deterministic_help = gengetopt_args_info_help[5] ;
+  args_info->previous_help = gengetopt_args_info_help[6] ;
+  args_info->edge_changes_help = gengetopt_args_info_help[7] ;
   
 }
 
@@ -162,6 +182,11 @@ cmdline_parser_release (struct gengetopt_args_info *args_info)
 {
   unsigned int i;
   free_string_field (&(args_info->k_orig));
+  free_string_field (&(args_info->threads_orig));
+  free_string_field (&(args_info->previous_arg));
+  free_string_field (&(args_info->previous_orig));
+  free_string_field (&(args_info->edge_changes_arg));
+  free_string_field (&(args_info->edge_changes_orig));
   
   
   for (i = 0; i < args_info->inputs_num; ++i)
@@ -204,6 +229,14 @@ cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
     write_into_file(outfile, "k", args_info->k_orig, 0);
   if (args_info->stringIDs_given)
     write_into_file(outfile, "stringIDs", 0, 0 );
+  if (args_info->threads_given)
+    write_into_file(outfile, "threads", args_info->threads_orig, 0);
+  if (args_info->deterministic_given)
+    write_into_file(outfile, "deterministic", 0, 0 );
+  if (args_info->previous_given)
+    write_into_file(outfile, "previous", args_info->previous_orig, 0);
+  if (args_info->edge_changes_given)
+    write_into_file(outfile, "edge-changes", args_info->edge_changes_orig, 0);
   
 
   i = EXIT_SUCCESS;
@@ -336,6 +369,7 @@ int update_arg(void *field, char **orig_field,
   char *stop_char = 0;
   const char *val = value;
   int found;
+  char **string_field;
 
   stop_char = 0;
   found = 0;
@@ -370,6 +404,14 @@ int update_arg(void *field, char **orig_field,
   case ARG_INT:
     if (val) *((int *)field) = strtol (val, &stop_char, 0);
     break;
+  case ARG_STRING:
+    if (val) {
+      string_field = (char **)field;
+      if (!no_free && *string_field)
+        free (*string_field); /* free previous string */
+      *string_field = gengetopt_strdup (val);
+    }
+    break;
   default:
     break;
   };
@@ -447,10 +489,14 @@ cmdline_parser_internal (int argc, char * const *argv, struct gengetopt_args_inf
         { "version",	0, NULL, 'V' },
         { "k",	1, NULL, 'k' },
         { "stringIDs",	0, NULL, 0 },
+        { "threads",	1, NULL, 't' },
+        { "deterministic",	0, NULL, 0 },
+        { "previous",	1, NULL, 0 },
+        { "edge-changes",	1, NULL, 0 },
         { NULL,	0, NULL, 0 }
       };
 
-      c = getopt_long (argc, argv, "hVk:", long_options, &option_index);
+      c = getopt_long (argc, argv, "hVk:t:", long_options, &option_index);
 
       if (c == -1) break;	/* Exit from `while (1)' loop.  */
 
@@ -478,6 +524,18 @@ cmdline_parser_internal (int argc, char * const *argv, struct gengetopt_args_inf
             goto failure;
         
           break;
+        case 't':	/* number of threads to enumerate with.  */
+        
+        
+          if (update_arg( (void *)&(args_info->threads_arg), 
+               &(args_info->threads_orig), &(args_info->threads_given),
+              &(local_args_info.threads_given), optarg, 0, "1", ARG_INT,
+              check_ambiguity, override, 0, 0,
+              "threads", 't',
+              additional_error))
+            goto failure;
+        
+          break;
 
         case 0:	/* Long option with no short option */
           /* string IDs in the input.  */
@@ -491,6 +549,46 @@ cmdline_parser_internal (int argc, char * const *argv, struct gengetopt_args_inf
                 additional_error))
               goto failure;
           
+          }
+          /* with several threads, print the cliques in the same order as one thread would.  */
+          else if (strcmp (long_options[option_index].name, "deterministic") == 0)
+          {
+          
+          
+            if (update_arg((void *)&(args_info->deterministic_flag), 0, &(args_info->deterministic_given),
+                &(local_args_info.deterministic_given), optarg, 0, 0, ARG_FLAG,
+                check_ambiguity, override, 1, 0, "deterministic", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* an earlier output of this program. With --edge-changes, print only the cliques added and removed since then.  */
+          else if (strcmp (long_options[option_index].name, "previous") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->previous_arg), 
+                 &(args_info->previous_orig), &(args_info->previous_given),
+                &(local_args_info.previous_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "previous", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* the edges added ('+ a b') and removed ('- a b') since --previous. The edge_list must be the new one.  */
+          else if (strcmp (long_options[option_index].name, "edge-changes") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->edge_changes_arg), 
+                 &(args_info->edge_changes_orig), &(args_info->edge_changes_given),
+                &(local_args_info.edge_changes_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "edge-changes", '-',
+                additional_error))
+              goto failure;
+          
           }
           
           break;
@@ -39,11 +39,26 @@ struct gengetopt_args_info
   const char *k_help; /**< @brief minimum size of clique, k. Must be at least 3. help description.  */
   int stringIDs_flag;	/**< @brief string IDs in the input (default=off).  */
   const char *stringIDs_help; /**< @brief string IDs in the input help description.  */
+  int threads_arg;	/**< @brief number of threads to enumerate with (default='1').  */
+  char * threads_orig;	/**< @brief number of threads to enumerate with original value given at command line.  */
+  const char *threads_help; /**< @brief number of threads to enumerate with help description.  */
+  int deterministic_flag;	/**< @brief with several threads, print the cliques in the same order as one thread would (default=off).  */
+  const char *deterministic_help; /**< @brief with several threads, print the cliques in the same order as one thread would help description.  */
+  char * previous_arg;	/**< @brief an earlier output of this program. With --edge-changes, print only the cliques added and removed since then.  */
+  char * previous_orig;	/**< @brief an earlier output of this program. With --edge-changes, print only the cliques added and removed since then original value given at command line.  */
+  const char *previous_help; /**< @brief an earlier output of this program. With --edge-changes, print only the cliques added and removed since then help description.  */
+  char * edge_changes_arg;	/**< @brief the edges added ('+ a b') and removed ('- a b') since --previous. The edge_list must be the new one.  */
+  char * edge_changes_orig;	/**< @brief the edges added ('+ a b') and removed ('- a b') since --previous. The edge_list must be the new one original value given at command line.  */
+  const char *edge_changes_help; /**< @brief the edges added ('+ a b') and removed ('- a b') since --previous. The edge_list must be the new one help description.  */
   
   unsigned int help_given ;	/**< @brief Whether help was given.  */
   unsigned int version_given ;	/**< @brief Whether version was given.  */
   unsigned int k_given ;	/**< @brief Whether k was given.  */
   unsigned int stringIDs_given ;	/**< @brief Whether stringIDs was given.  */
+  unsigned int threads_given ;	/**< @brief Whether threads was given.  */
+  unsigned int deterministic_given ;	/**< @brief Whether deterministic was given.  */
+  unsigned int previous_given ;	/**< @brief Whether previous was given.  */
+  unsigned int edge_changes_given ;	/**< @brief Whether edge-changes was given.  */
 
   char **inputs ; /**< @brief unamed options (options without names) */
   unsigned inputs_num ; /**< @brief unamed options number */
@@ -3,35 +3,44 @@
 #include "graph/stats.hpp"
 #include "macros.hpp"
 #include "cliques.hpp"
+#include "output.hpp"
+#include "clique_store.hpp"
+#include "threads.hpp"
 #include "cmdline-cp5.h"
 #include "comments.hh"
 
 #include <vector>
 #include <tr1/unordered_set>
+#include <tr1/unordered_map>
 #include <map>
 #include <set>
 #include <stack>
-#include <bitset>
 
 #include <algorithm>
 #include <tr1/functional>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 
 #include <getopt.h>
 #include <libgen.h>
 #include <cassert>
 #include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <limits>
 #include <sys/stat.h> // for mkdir
+#include <sys/time.h> // for gettimeofday
+#include <unistd.h> // for fsync
 #include <sys/types.h> // for mkdir
 
 
 using namespace std;
 
-typedef vector<int32_t> clique; // the nodes will be in increasing numerical order
+typedef clique_store :: clique_view clique; // the nodes will be in increasing numerical order
+using clique_store :: clique_set; // all the cliques, in one flat array
 
 template<typename T>
 string thou(T number);
@@ -39,26 +48,42 @@ string thou(T number);
 #define ELAPSED (double(clock())/CLOCKS_PER_SEC)
 #define HOWLONG "(runtime: " << ELAPSED <<"s)"
 
+/*
+ * Clique ids, and the component and search-tree branch ids made from them, are of type Id
+ * throughout: int32_t while there are few enough cliques, for the compact layout, and
+ * int64_t beyond that. The same code is compiled for both, and main picks one once the
+ * cliques have been counted. Node ids are int32_t either way, as in the graph library.
+ */
+static bool small_enough_for_32_bit_ids(const int64_t C) { // the branches of the search tree go up to 4*C
+	return C <= std :: numeric_limits<int32_t> :: max() / 4;
+}
+
+template<typename Id>
 class comp { // which component, if any, is this node in?
 private:
-	const int32_t N;
-	vector<int32_t> com; // initialize with everything in cluster '0'
-	int32_t num_components;
+	const Id N;
+	vector<Id> com; // initialize with everything in cluster '0'
+	Id num_components;
 public:
-	comp(int32_t _N) : N(_N), com(N,0), num_components(1) { // one giant component at first
+	comp(Id _N) : N(_N), com(N,0), num_components(1) { // one giant component at first
+	}
+	comp(const vector<Id> &_com, Id _num_components) : N(_com.size()), com(_com), num_components(_num_components) { // e.g. from a checkpoint
+	}
+	Id size() const { // the cliques [0, N). The ones above that are too small for this level
+		return this->N;
 	}
-	int32_t my_component_id(const int32_t node_id) const {
-		int32_t id = this->com.at(node_id);
+	Id my_component_id(const Id node_id) const {
+		Id id = this->com.at(node_id);
 		assert(id >= 0);
 		return id;
 	}
-	int32_t component_count() const {
+	Id component_count() const {
 		return this->num_components;
 	}
-	int32_t create_empty_component() {
+	Id create_empty_component() {
 		return this->num_components ++; // must be *post* increment
 	}
-	void move_node(int32_t node_id, int32_t to, int32_t from) {
+	void move_node(Id node_id, Id to, Id from) {
 		assert(node_id >= 0);
 		assert(node_id < this->N);
 		assert(to >= 0);
@@ -68,24 +93,25 @@ public:
 		assert(this->com.at(node_id) == from);
 		this->com.at(node_id) = to;
 	}
-	const vector<int32_t> & get_com() const {
+	const vector<Id> & get_com() const {
 		return com;
 	}
 };
+template<typename Id>
 class maybe_available { // a stack of node_ids that are available (i.e. in the source_component, but not yet assigned to a community
 private:
-	vector<int32_t> potentially_available; // will be used as a stack; push_back and pop_back
+	vector<Id> potentially_available; // will be used as a stack; push_back and pop_back
 public:
-	const vector<int32_t> & get_all_members() const {
+	const vector<Id> & get_all_members() const {
 		return this->potentially_available;
 	}
-	void insert(int32_t c) {
+	void insert(Id c) {
 		this->potentially_available.push_back(c);
 	}
 	size_t size() const {
 		return this->potentially_available.size();
 	}
-	int32_t get_next(const comp &current_component, int32_t source_component) { // return -1 if none available
+	Id get_next(const comp<Id> &current_component, Id source_component) { // return -1 if none available
 		//PP2(__LINE__, ELAPSED);
 		// pop items from the stack until one is identified which hasn't yet been assigned in the current_component
 		// if called repeatedly, it'll return the same value, at least until the relevant node (i.e. clique) is moved from source_component
@@ -94,7 +120,7 @@ public:
 				//PP2(__LINE__, ELAPSED);
 				return -1;
 			}
-			const int32_t node_id = this->potentially_available.back();
+			const Id node_id = this->potentially_available.back();
 			if(current_component.my_component_id(node_id) == source_component) {
 				//PP2(__LINE__, ELAPSED);
 				return node_id;
@@ -104,24 +130,105 @@ public:
 	}
 };
 
-
-static void do_clique_percolation_variant_5b(const int32_t min_k, const int32_t max_k, const int32_t max_k_to_percolate, const vector< clique > &the_cliques, const char * output_dir_name, const graph :: NetworkInterfaceConvertedToString *network) ;
+template<typename Id>
+class clique_postings { // for each node, the ids of the cliques it's in. Built up as the cliques arrive from the enumeration
+	vector< vector<Id> > of_node;
+	int64_t total;
+public:
+	clique_postings() : total(0) {}
+	void add(const Id clique_id, const clique &cl) { // clique_ids must arrive in increasing order
+		For(node, cl) {
+			if(size_t(*node) >= this->of_node.size())
+				this->of_node.resize(*node + 1);
+			this->of_node.at(*node).push_back(clique_id);
+		}
+		this->total += cl.size();
+	}
+	bool empty() const { return this->total == 0; }
+	void clear() {
+		vector< vector<Id> >().swap(this->of_node);
+		this->total = 0;
+	}
+	void move_to_csr(vector<int64_t> &postings_begin, vector<Id> &postings) { // leaves this empty. The postings of node n are then [postings_begin[n], postings_begin[n+1])
+		const int32_t N = this->of_node.size();
+		postings_begin.assign(N+1, 0);
+		postings.clear();
+		postings.reserve(this->total);
+		for(int32_t n = 0; n < N; n++) {
+			postings.insert(postings.end(), this->of_node.at(n).begin(), this->of_node.at(n).end());
+			vector<Id>().swap(this->of_node.at(n)); // free it now, to keep the peak down
+			postings_begin.at(n+1) = postings.size();
+		}
+		this->clear();
+	}
+};
+/*
+ * Checkpoints. Once level k has been written, <output_dir>/checkpoint records its comp and
+ * found communities; that's all that's needed to carry on with k+1. The cliques themselves
+ * are in <output_dir>/cliques.bin. --resume DIR checks that the edge list and the cliques
+ * are the ones the checkpoint was made from, and carries on from there.
+ */
+struct run_identity {
+	uint64_t graph_hash; // of the edge list file, and of --stringIDs
+	uint64_t cliques_hash;
+	int32_t min_k;
+};
+struct checkpoint_header {
+	run_identity id;
+	int32_t k; // the last level that was completely written
+	int64_t num_components;
+	int64_t C; // the size of com. The cliques above that are too small for level k
+	int32_t id_bytes; // as written. It needn't be sizeof(Id) of the run that reads it
+	int32_t version; // 1 or 2, see write_checkpoint
+};
+template<typename Id>
+struct checkpoint : public checkpoint_header {
+	vector<Id> com; // the comp for level k
+	vector<Id> found_communities;
+};
+template<typename Id>
+static void write_checkpoint(const char * output_dir_name, const run_identity &id, const int32_t k, const comp<Id> &level, const vector<Id> &found_communities);
+static FILE * read_checkpoint_header_or_die(const char * output_dir_name, checkpoint_header &ck); // the caller must fclose it
+template<typename Id>
+static void read_checkpoint_or_die(const char * output_dir_name, checkpoint<Id> &ck);
+
+template<typename Id>
+static void percolate_every_level(const int32_t min_k, const int32_t max_k, const int32_t max_k_to_percolate, const clique_set &the_cliques, const char * output_dir_name, const output :: node_name_cache &names, clique_postings<Id> &warm_postings, const run_identity &id, const bool resuming) ;
+template<typename Id>
+static void do_clique_percolation_variant_5b(const int32_t min_k, const int32_t max_k, const int32_t max_k_to_percolate, const clique_set &the_cliques, const char * output_dir_name, const output :: node_name_cache &names, clique_postings<Id> &warm_postings, const run_identity &id, const checkpoint<Id> * resume_from) ;
+template<typename Id>
+static void do_clique_percolation_in_one_sweep(const int32_t min_k, const int32_t max_k_to_percolate, const clique_set &the_cliques, const char * output_dir_name, const output :: node_name_cache &names, clique_postings<Id> &warm_postings) ;
+template<typename Id>
+static void do_clique_percolation_in_parallel(const int32_t min_k, const int32_t max_k_to_percolate, const clique_set &the_cliques, const char * output_dir_name, const output :: node_name_cache &names, const int num_threads, const run_identity &id, const checkpoint<Id> * resume_from) ;
+template<typename Id>
 static void write_all_communities_for_this_k(const char * output_dir_name
 		, const int32_t k
-		, const vector<int32_t> &found_communities
-		, const comp & current_percolation_level
-		, const vector<clique> &the_cliques
-		, const graph :: NetworkInterfaceConvertedToString *network
+		, const vector<Id> &found_communities
+		, const comp<Id> & current_percolation_level
+		, const clique_set &the_cliques
+		, const output :: node_name_cache &names
 		);
 static void create_directory_for_output(const char *dir);
+template<typename Id>
+static bool put_the_cliques_in_order(clique_set &the_cliques, const char * order_name, const string &file_name);
+static void save_cliques_or_die(const clique_set &the_cliques, const string &file_name);
+static void check_loaded_cliques_or_die(const clique_set &the_cliques, const int32_t min_k, const int32_t num_nodes, const string &file_name);
+static void save_node_names_or_die(const output :: node_name_cache &names, const string &file_name);
+static void update_communities_incrementally(const graph :: NetworkInterfaceConvertedToString *net, const int32_t min_k, const int32_t max_k_to_percolate, const char * previous_dir_name, const char * changes_file_name, const char * output_dir_name);
+static uint64_t hash_of_file_or_die(const char * file_name);
+static uint64_t hash_of_cliques(const clique_set &the_cliques);
+static void open_search_stats_or_die(const char * file_name);
+static threads :: thread * start_thread_or_die(threads :: runnable &r);
+static void close_search_stats();
+template<typename Id>
 static void source_components_for_the_next_level (
-		vector<int32_t> &source_components
-		, vector<maybe_available>  & members_of_the_source_components
-		, comp * new_percolation_level
+		vector<Id> &source_components
+		, vector< maybe_available<Id> >  & members_of_the_source_components
+		, comp<Id> * new_percolation_level
 		, const int32_t new_k
-		, const vector<int32_t> &found_communities
-		, const comp * old_percolation_level
-		, const vector<clique> &the_cliques
+		, const vector<Id> &found_communities
+		, const comp<Id> * old_percolation_level
+		, const clique_set &the_cliques
 		) ; // identify candidates for the next level
 
 
@@ -139,6 +246,15 @@ static string memory_usage() {
 }
 
 static bool global_rebuild_occasionally = false; 
+static bool global_counting_bloom = false; // --counting-bloom
+class search_stats_file;
+static search_stats_file * global_search_stats = NULL; // --search-stats
+static bool global_search_with_index = false; // --search=index, rather than the bloom-filtered tree
+static bool global_recursive_search = false; // --search=bloom-recursive, the search of the tree one branch at a time
+static bool global_single_sweep = false; // --sweep, all k at once via union-find, rather than one_k for each k
+static bool global_binary_output = false; // --binary-output
+static int global_num_threads = 1; // --threads
+static int64_t global_memory_limit = 0; // --memory-limit, in bytes. 0 for no limit
 
 int main(int argc, char **argv) {
 	gengetopt_args_info args_info;
@@ -147,17 +263,56 @@ int main(int argc, char **argv) {
 	if (cmdline_parser (argc, argv, &args_info) != 0)
 		exit(1) ;
 	// .. and there should be exactly one non-option arg
-	if(args_info.inputs_num != 2 || args_info.k_arg < 3) {
+	if(args_info.inputs_num != (args_info.resume_given ? 1 : 2) || args_info.k_arg < 3 || args_info.threads_arg < 1) {
 		cmdline_parser_print_help();
 		exit(1);
 	}
+	if(args_info.incremental_given != args_info.edge_changes_given
+			|| (args_info.incremental_given && (args_info.resume_given || args_info.load_cliques_given || args_info.sweep_flag || args_info.memory_limit_given || args_info.clique_order_given))) {
+		cerr << "Error: --incremental and --edge-changes go together, and not with --resume, --load-cliques, --sweep, --memory-limit or --clique-order. Exiting." << endl;
+		exit(1);
+	}
 
 	if(args_info.comments_flag)
 		cout << commentSlashes;
 	PP(args_info.rebuild_bloom_flag);
 	global_rebuild_occasionally = args_info.rebuild_bloom_flag;
+	global_search_with_index = 0 == strcmp(args_info.search_arg, "index");
+	global_recursive_search = 0 == strcmp(args_info.search_arg, "bloom-recursive");
+	PP(args_info.search_arg);
+	global_counting_bloom = args_info.counting_bloom_flag;
+	PP(args_info.counting_bloom_flag);
+	if(global_counting_bloom && (global_rebuild_occasionally || global_search_with_index)) {
+		cerr << "Error: --counting-bloom is never out of date, so there's nothing for --rebuild.bloom to do, and it's only for --search=bloom. Exiting." << endl;
+		exit(1);
+	}
+	global_single_sweep = args_info.sweep_flag;
+	if(args_info.search_stats_given) { // written as the levels are done
+		if(global_search_with_index || global_single_sweep || args_info.threads_arg > 1 || args_info.memory_limit_given || args_info.incremental_given) {
+			cerr << "Error: --search-stats is for the search of the tree, one source component after another: not --search=index, --sweep, --threads, --memory-limit or --incremental. Exiting." << endl;
+			exit(1);
+		}
+		open_search_stats_or_die(args_info.search_stats_arg);
+	}
+	PP(args_info.threads_arg);
+	global_num_threads = args_info.threads_arg;
+	global_binary_output = args_info.binary_output_flag;
+	PP(args_info.sweep_flag);
+	if(args_info.memory_limit_given) {
+		if(args_info.memory_limit_arg < 1 || global_single_sweep) {
+			cerr << "Error: --memory-limit needs a positive number of megabytes, and can't be used with --sweep (which keeps every overlapping pair in memory). Exiting." << endl;
+			exit(1);
+		}
+		global_memory_limit = int64_t(args_info.memory_limit_arg) << 20;
+		PP(args_info.memory_limit_arg);
+	}
+	PP(args_info.clique_order_arg);
+	if(global_memory_limit && 0 == strcmp(args_info.clique_order_arg, "rcm-on-clique-graph")) {
+		cerr << "Error: --clique-order=rcm-on-clique-graph needs every clique's neighbours in memory, so it can't be used with --memory-limit. Exiting." << endl;
+		exit(1);
+	}
 	const char * edgeListFileName   = args_info.inputs[0];
-	const char * output_dir_name   = args_info.inputs[1];
+	const char * output_dir_name   = args_info.resume_given ? args_info.resume_arg : args_info.inputs[1];
 	const int min_k = args_info.k_arg;
 	int max_k_to_percolate = args_info.K_arg;
 	if(args_info.K_arg == -1) // default to using as many as possible
@@ -186,19 +341,115 @@ int main(int argc, char **argv) {
 		<< " Max degree is " << maxDegree
 	       << endl;
 
-	vector< clique > the_cliques;
-	cliques :: cliquesToVector(network.get(), min_k, the_cliques);
+	if(args_info.incremental_given) {
+		global_binary_output = true; // so that the next --incremental can use this run's percolated_cliques<k>.bin
+		update_communities_incrementally(network.get(), min_k, max_k_to_percolate, args_info.incremental_arg, args_info.edge_changes_arg, output_dir_name);
+		return 0;
+	}
 
-	// sort 'em here? By size? lexicographically? Graclus?
+	run_identity id;
+	id.graph_hash = hash_of_file_or_die(edgeListFileName) ^ (args_info.stringIDs_flag ? 1 : 0);
+	id.min_k = min_k;
+	const bool resuming = args_info.resume_given;
+	checkpoint_header resume_from; // just the header. The rest is read once we know how wide the ids are
+	if(resuming) {
+		fclose(read_checkpoint_header_or_die(output_dir_name, resume_from));
+		if(resume_from.id.graph_hash != id.graph_hash || resume_from.id.min_k != min_k) {
+			cerr << endl << "Error: the checkpoint in \"" << output_dir_name << "\" was made from a different edge list, or with different -k or --stringIDs. Exiting." << endl;
+			exit(1);
+		}
+		cout << "Resuming after k = " << resume_from.k << endl;
+	}
 
-	const int32_t C = the_cliques.size();
+	/* The enumeration runs on its own thread, and we take the cliques as they come,
+	 * rather than waiting for the whole vector. With --memory-limit, they go straight
+	 * into <output_dir>/cliques.bin, which is then mapped, so they're never all in memory.
+	 * Then they're sorted, biggest first, and in the --clique-order within each size.
+	 * If the percolation will want an index (node -> cliques) for the first level, it's
+	 * built from the sorted cliques.
+	 */
+	clique_set the_cliques;
+	clique_postings<int32_t> warm_postings; // only while the ids are small enough. See below for the rest
+	bool saving_cliques_in_output_dir = false; // and hence their node names, see update_communities_incrementally
+	bool cliques_already_in_output_dir = false;
+	const bool want_postings = global_single_sweep || (global_search_with_index && args_info.threads_arg == 1 && !resuming && !global_memory_limit);
+	if(args_info.load_cliques_given || resuming) { // enumerated on an earlier run
+		try {
+			the_cliques.map_file(resuming ? string(output_dir_name) + "/cliques.bin" : string(args_info.load_cliques_arg));
+		} catch (std :: runtime_error &e) {
+			cerr << endl << "Error: " << e.what() << ". Exiting." << endl;
+			exit(1);
+		}
+		check_loaded_cliques_or_die(the_cliques, min_k, network->numNodes(), resuming ? string(output_dir_name) + "/cliques.bin" : string(args_info.load_cliques_arg));
+	} else if(global_memory_limit) {
+		saving_cliques_in_output_dir = true;
+		cliques_already_in_output_dir = true;
+		create_directory_for_output(output_dir_name);
+		const string file_name = string(output_dir_name) + "/cliques.bin";
+		try {
+			clique_store :: clique_file_writer out(file_name);
+			cliques :: clique_stream stream(network->get_plain_graph(), min_k);
+			const int32_t * nodes;
+			size_t size;
+			while(stream.next(nodes, size))
+				out.push_back(nodes, nodes + size);
+			out.close();
+			the_cliques.map_file(file_name);
+		} catch (std :: runtime_error &e) {
+			cerr << endl << "Error: " << e.what() << ". Exiting." << endl;
+			exit(1);
+		}
+	} else {
+		try {
+			cliques :: clique_stream stream(network->get_plain_graph(), min_k);
+			const int32_t * nodes;
+			size_t size;
+			while(stream.next(nodes, size))
+				the_cliques.push_back(nodes, nodes + size); // already sorted
+		} catch (std :: runtime_error &e) {
+			cerr << endl << "Error: " << e.what() << ". Exiting." << endl;
+			exit(1);
+		}
+	}
+	unless(resuming) { // on --resume, cliques.bin is in the order of the first run already
+		const string file_name = global_memory_limit ? string(output_dir_name) + "/cliques.bin" : ""; // with --memory-limit, the reordered cliques go on disk too
+		if(global_memory_limit)
+			create_directory_for_output(output_dir_name);
+		const bool reordered = small_enough_for_32_bit_ids(the_cliques.size())
+			? put_the_cliques_in_order<int32_t>(the_cliques, args_info.clique_order_arg, file_name)
+			: put_the_cliques_in_order<int64_t>(the_cliques, args_info.clique_order_arg, file_name);
+		if(reordered && global_memory_limit) {
+			saving_cliques_in_output_dir = true;
+			cliques_already_in_output_dir = true;
+		}
+	}
+	if(want_postings && small_enough_for_32_bit_ids(the_cliques.size()))
+		for(size_t c = 0; c < the_cliques.size(); c++)
+			warm_postings.add(c, the_cliques.at(c));
+	if(args_info.save_cliques_given)
+		save_cliques_or_die(the_cliques, args_info.save_cliques_arg);
+	id.cliques_hash = hash_of_cliques(the_cliques);
+	if(resuming) {
+		if(resume_from.id.cliques_hash != id.cliques_hash || resume_from.C > int64_t(the_cliques.size())) { // its comp only goes up to the last clique big enough for its k
+			cerr << endl << "Error: \"" << output_dir_name << "/cliques.bin\" doesn't match its checkpoint. Exiting." << endl;
+			exit(1);
+		}
+	} else if(cliques_already_in_output_dir) {
+		// they're in <output_dir>/cliques.bin already
+	} else if(!global_single_sweep || global_binary_output) { // for the checkpoints, and for percolated_cliques<k>.bin
+		saving_cliques_in_output_dir = true;
+		create_directory_for_output(output_dir_name);
+		save_cliques_or_die(the_cliques, string(output_dir_name) + "/cliques.bin");
+	}
+
+	const int64_t C = the_cliques.size();
 	if(C==0) {
 		cerr << endl << "Error: you don't have any cliques of at least size " << min_k << ". Exiting." << endl;
 		exit(1);
 	}
-	std :: map<size_t, int32_t> cliqueFrequencies;
-	for(vector<clique > :: const_iterator i = the_cliques.begin(); i != the_cliques.end(); i++) {
-		++cliqueFrequencies[i->size()];
+	std :: map<size_t, int64_t> cliqueFrequencies;
+	for(int64_t c = 0; c < C; c++) {
+		++cliqueFrequencies[the_cliques.at(c).size()];
 	}
 	assert(!cliqueFrequencies.empty());
 	int max_clique_size = cliqueFrequencies.rbegin()->first;
@@ -211,62 +462,424 @@ int main(int argc, char **argv) {
 		cout << "# " << k << '\t' << cliqueFrequencies[k] << endl;
 	}
 
+	const output :: node_name_cache names(network.get()); // every node name is rendered once, and shared by all the levels' writers
+	if(saving_cliques_in_output_dir)
+		save_node_names_or_die(names, string(output_dir_name) + "/node_names");
+
 	// finally, call the clique_percolation algorithm proper
 
-	do_clique_percolation_variant_5b(min_k, max_clique_size, max_k_to_percolate, the_cliques, output_dir_name, network.get());
+	if(resuming && resume_from.k >= max_k_to_percolate) {
+		cout << "Every level up to k = " << max_k_to_percolate << " was already done." << endl;
+	} else if(small_enough_for_32_bit_ids(C)) {
+		percolate_every_level<int32_t>(min_k, max_clique_size, max_k_to_percolate, the_cliques, output_dir_name, names, warm_postings, id, resuming);
+	} else {
+		cout << thou(C) << " cliques. Using 64-bit clique ids" << endl;
+		warm_postings.clear();
+		clique_postings<int64_t> wide_postings;
+		if(want_postings)
+			for(int64_t c = 0; c < C; c++)
+				wide_postings.add(c, the_cliques.at(c));
+		percolate_every_level<int64_t>(min_k, max_clique_size, max_k_to_percolate, the_cliques, output_dir_name, names, wide_postings, id, resuming);
+	}
+	close_search_stats();
+}
+
+template<typename Id>
+static void percolate_every_level(const int32_t min_k, const int32_t max_k, const int32_t max_k_to_percolate, const clique_set &the_cliques, const char * output_dir_name, const output :: node_name_cache &names, clique_postings<Id> &warm_postings, const run_identity &id, const bool resuming) {
+	std :: auto_ptr< checkpoint<Id> > resume_from;
+	if(resuming) {
+		resume_from.reset(new checkpoint<Id>);
+		read_checkpoint_or_die(output_dir_name, *resume_from);
+	}
+	if(global_single_sweep) { // there are no checkpoints for this, it goes down from the largest k. See do_clique_percolation_in_one_sweep
+		if(resuming)
+			cerr << "Warning: --sweep ignores the checkpoint, and redoes every level" << endl;
+		do_clique_percolation_in_one_sweep(min_k, max_k_to_percolate, the_cliques, output_dir_name, names, warm_postings);
+	} else if(global_num_threads > 1 || global_memory_limit) // one source component at a time, so everything but the cliques is sized for that component
+		do_clique_percolation_in_parallel(min_k, max_k_to_percolate, the_cliques, output_dir_name, names, global_num_threads, id, resume_from.get());
+	else
+		do_clique_percolation_variant_5b(min_k, max_k, max_k_to_percolate, the_cliques, output_dir_name, names, warm_postings, id, resume_from.get());
 }
 
-const static size_t BLOOM_BITS = 4000000000UL;  /// 0.50 GB    // for 32-bit
-// const static size_t BLOOM_BITS = 40000000000UL; /// 5.00 GB // for 64-bit
+/*
+ * The cliques are always sorted biggest first, so that each level's cliques are a prefix of
+ * the ids; see cliques_of_each_level. Within each size, they're in the --clique-order.
+ * The cliques, in id order, are the leaves of the intersecting_clique_finder's
+ * tree, so each branch's Bloom filter holds the nodes of a run of consecutive cliques. In the
+ * order they were found in, neighbouring cliques often have little to do with each other, and
+ * the filters near the root are full of unrelated nodes. With cliques that share nodes next
+ * to each other, the filters are sparser, and recursive_search gives up on more branches.
+ *  - bk: as they were found
+ *  - lex: in lexicographic order of their nodes
+ *  - minnode: by their smallest node, and otherwise as they were found
+ *  - rcm-on-clique-graph: reverse Cuthill-McKee on the graph in which two cliques are adjacent
+ *    if they share a node. Each node's cliques are only expanded once, by the first clique
+ *    to reach it, so it's linear in the total size of the cliques.
+ * It's the reordered cliques that are saved, so the clique ids in cliques.bin, the checkpoints
+ * and percolated_cliques<k>.bin are all in the new order.
+ */
+struct bigger_clique_first {
+	const clique_set &the_cliques;
+	explicit bigger_clique_first(const clique_set &_the_cliques) : the_cliques(_the_cliques) {}
+	template<typename Id>
+	bool operator() (const Id l, const Id r) const {
+		return this->the_cliques.at(l).size() > this->the_cliques.at(r).size();
+	}
+};
+struct lexicographic_clique_order {
+	const clique_set &the_cliques;
+	explicit lexicographic_clique_order(const clique_set &_the_cliques) : the_cliques(_the_cliques) {}
+	template<typename Id>
+	bool operator() (const Id l, const Id r) const {
+		const clique a = this->the_cliques.at(l);
+		const clique b = this->the_cliques.at(r);
+		return lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+	}
+};
+struct smallest_node_first {
+	const clique_set &the_cliques;
+	explicit smallest_node_first(const clique_set &_the_cliques) : the_cliques(_the_cliques) {}
+	template<typename Id>
+	bool operator() (const Id l, const Id r) const {
+		return this->the_cliques.at(l).front() < this->the_cliques.at(r).front();
+	}
+};
+struct fewer_neighbours_first {
+	const vector<int64_t> &degree;
+	explicit fewer_neighbours_first(const vector<int64_t> &_degree) : degree(_degree) {}
+	template<typename Id>
+	bool operator() (const Id l, const Id r) const {
+		return this->degree.at(l) < this->degree.at(r);
+	}
+};
+template<typename Id>
+static void reverse_cuthill_mckee_order(const clique_set &the_cliques, vector<Id> &order) {
+	const Id C = the_cliques.size();
+	vector<int64_t> postings_begin;
+	vector<Id> postings;
+	{
+		clique_postings<Id> every_clique;
+		for(Id c = 0; c < C; c++)
+			every_clique.add(c, the_cliques.at(c));
+		every_clique.move_to_csr(postings_begin, postings);
+	}
+	vector<int64_t> degree(C, 0); // [clique]. The other cliques on each of its nodes, summed over its nodes
+	for(Id c = 0; c < C; c++)
+		For(node, the_cliques.at(c))
+			degree.at(c) += postings_begin.at(*node + 1) - postings_begin.at(*node) - 1;
+	vector<Id> by_degree(C);
+	for(Id c = 0; c < C; c++)
+		by_degree.at(c) = c;
+	stable_sort(by_degree.begin(), by_degree.end(), fewer_neighbours_first(degree));
+
+	vector<bool> visited(C, false);
+	vector<bool> expanded(postings_begin.size() - 1, false); // [node]
+	vector<Id> fresh;
+	order.clear();
+	order.reserve(C);
+	For(start, by_degree) { // each unvisited clique of least degree starts a breadth-first search of its connected component
+		if(visited.at(*start))
+			continue;
+		visited.at(*start) = true;
+		order.push_back(*start);
+		for(size_t head = order.size() - 1; head < order.size(); head++) { // order itself is the queue
+			fresh.clear();
+			For(node, the_cliques.at(order.at(head))) {
+				if(expanded.at(*node))
+					continue;
+				expanded.at(*node) = true;
+				for(int64_t p = postings_begin.at(*node); p < postings_begin.at(*node + 1); p++) {
+					const Id d = postings.at(p);
+					unless(visited.at(d)) {
+						visited.at(d) = true;
+						fresh.push_back(d);
+					}
+				}
+			}
+			stable_sort(fresh.begin(), fresh.end(), fewer_neighbours_first(degree));
+			order.insert(order.end(), fresh.begin(), fresh.end());
+		}
+	}
+	assert(Id(order.size()) == C);
+	reverse(order.begin(), order.end());
+}
+template<typename Id>
+static bool put_the_cliques_in_order(clique_set &the_cliques, const char * order_name, const string &file_name) { // if file_name isn't empty, the reordered cliques are written there, and mapped. False if they were in order already
+	const double started = ELAPSED;
+	const Id C = the_cliques.size();
+	vector<Id> order(C);
+	for(Id c = 0; c < C; c++)
+		order.at(c) = c;
+	if(0 == strcmp(order_name, "lex"))
+		sort(order.begin(), order.end(), lexicographic_clique_order(the_cliques));
+	else if(0 == strcmp(order_name, "minnode"))
+		stable_sort(order.begin(), order.end(), smallest_node_first(the_cliques));
+	else if(0 == strcmp(order_name, "rcm-on-clique-graph"))
+		reverse_cuthill_mckee_order(the_cliques, order);
+	else
+		assert(0 == strcmp(order_name, "bk"));
+	stable_sort(order.begin(), order.end(), bigger_clique_first(the_cliques));
+	Id already_in_place = 0;
+	while(already_in_place < C && order.at(already_in_place) == already_in_place)
+		++ already_in_place;
+	if(already_in_place == C) // e.g. --load-cliques of a file saved by --save-cliques
+		return false;
+	clique_set ordered;
+	if(file_name.empty()) {
+		ordered.reserve(C, the_cliques.total_nodes());
+		For(c, order)
+			ordered.push_back(the_cliques.at(*c));
+	} else {
+		const string tmp_file_name = file_name + ".tmp";
+		try {
+			clique_store :: clique_file_writer out(tmp_file_name);
+			For(c, order)
+				out.push_back(the_cliques.at(*c));
+			out.close();
+			ordered.map_file(tmp_file_name);
+		} catch (std :: runtime_error &e) {
+			cerr << endl << "Error: " << e.what() << ". Exiting." << endl;
+			exit(1);
+		}
+		if(rename(tmp_file_name.c_str(), file_name.c_str()) != 0) { // the old file stays mapped until the swap below lets it go
+			cerr << endl << "Couldn't rename \"" << tmp_file_name << "\" to \"" << file_name << "\". Exiting." << endl;
+			exit(1);
+		}
+	}
+	the_cliques.swap(ordered);
+	cout << "Put the cliques in order, biggest first and then " << order_name << ", in " << ELAPSED - started << "s." << endl;
+	return true;
+}
+
+const static int64_t BLOOM_MAX_BITS = 4000000000LL;  /// 0.50 GB. Only reached for enormous source components; correctness never depends on the size
+static uint64_t mix64(uint64_t h) { // the finalizer from MurmurHash3
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+static const uintptr_t CACHE_LINE_BYTES = 64;
+static uint64_t * cache_line_aligned(uint64_t * p) { // p, rounded up to the start of the next cache line
+	return reinterpret_cast<uint64_t *>((reinterpret_cast<uintptr_t>(p) + CACHE_LINE_BYTES - 1) & ~(CACHE_LINE_BYTES - 1));
+}
+struct bloom_probe { // where a key's bits (or counters) are: its block, and the hash that picks them within the block
+	const uint64_t * block;
+	uint64_t bits;
+};
 class bloom { // http://en.wikipedia.org/wiki/Bloom_filter
-	std :: auto_ptr<bitset<BLOOM_BITS> > data;
+	/*
+	 * Blocked: every key lives in a single 512-bit block (one cache line), and sets/tests
+	 * a few bits in it. A big vector is only 16-byte aligned, so data has a block's worth
+	 * of spare words, and the blocks start at the first cache line in it.
+	 * The block and the bits come from a proper 64-bit mix of the key;
+	 * tr1 :: hash<int64_t> is the identity, which wasted the old filter's single probe.
+	 * The filter is sized from the number of insertions we expect, hence clearing it
+	 * is proportional to what will be put in it, not a fixed half-gigabyte.
+	 */
+	static const int64_t BLOCK_WORDS = 8; // 8 * 64 = 512 bits
+	static const int     PROBES = 4;
+	static const int64_t BITS_PER_INSERTION = 16;
+	vector<uint64_t> data;
+	uint64_t * blocks; // in data, cache line aligned
+	int64_t num_blocks;
+	bloom(const bloom &); // blocks points into data
+	bloom & operator= (const bloom &);
+	const uint64_t * block_for(const uint64_t h) const { return this->blocks + (h % this->num_blocks) * BLOCK_WORDS; }
+	      uint64_t * block_for(const uint64_t h)       { return this->blocks + (h % this->num_blocks) * BLOCK_WORDS; }
 public: // make private
-	static const int64_t l;
+	int64_t l; // the number of bits
 	int64_t occupied;
 	int64_t calls_to_set;
-	std :: tr1 :: hash<int64_t> h;
 public:
-	void clear() {
-		this->data->reset();
+	void clear(const int64_t expected_insertions) {
+		int64_t bits = max(int64_t(1), expected_insertions) * BITS_PER_INSERTION;
+		if(bits > BLOOM_MAX_BITS)
+			bits = BLOOM_MAX_BITS;
+		if(global_memory_limit && bits > 2 * global_memory_limit) // a quarter of the budget
+			bits = 2 * global_memory_limit;
+		this->num_blocks = (bits + 64*BLOCK_WORDS - 1) / (64*BLOCK_WORDS);
+		this->l = this->num_blocks * 64*BLOCK_WORDS;
+		this->data.assign(this->num_blocks * BLOCK_WORDS + BLOCK_WORDS - 1, 0); // this reuses the old allocation if it is big enough
+		this->blocks = cache_line_aligned(&this->data.front());
 		this->occupied = 0;
 		this->calls_to_set = 0;
 	}
-	bloom() : data(new bitset<BLOOM_BITS>) {
-		this->clear();
+	bloom() : blocks(NULL), num_blocks(0), l(0), occupied(0), calls_to_set(0) {
+		this->clear(0);
+	}
+	bloom_probe probe_for(const uint64_t a) const { // then prefetch() and test() it, to do several keys' cache misses at once
+		const uint64_t h = mix64(a);
+		const bloom_probe probe = { this->block_for(h), mix64(h ^ 0x9e3779b97f4a7c15ULL) };
+		return probe;
+	}
+	static void prefetch(const bloom_probe &probe) { // the block is one cache line
+		__builtin_prefetch(probe.block);
+	}
+	static bool test(const bloom_probe &probe) {
+		uint64_t bits = probe.bits; // each probe takes 9 bits of this
+		for(int p = 0; p < PROBES; p++, bits >>= 9) {
+			const int bit = int(bits & 511);
+			unless(probe.block[bit >> 6] & (uint64_t(1) << (bit & 63)))
+				return false;
+		}
+		return true;
 	}
-	bool test(const int64_t a) const {
-		const int64_t b = h(a) % l;
-		return this->data->test(b);
+	bool test(const uint64_t a) const {
+		return test(this->probe_for(a));
 	}
-	void set(const int64_t a)  {
+	void set(const uint64_t a)  {
 		++ this->calls_to_set;
-		const int64_t b = h(a) % l;
-		bool pre = this->data->test(b);
-		this->data->set(b);
-		if(!pre) {
-			++ this->occupied;
+		const uint64_t h = mix64(a);
+		uint64_t * block = this->block_for(h);
+		uint64_t bits = mix64(h ^ 0x9e3779b97f4a7c15ULL);
+		for(int p = 0; p < PROBES; p++, bits >>= 9) {
+			const int bit = int(bits & 511);
+			const uint64_t mask = uint64_t(1) << (bit & 63);
+			if(!(block[bit >> 6] & mask)) {
+				block[bit >> 6] |= mask;
+				++ this->occupied;
+			}
 		}
 	}
 };
-const int64_t bloom :: l = BLOOM_BITS;
-// const int64_t bloom :: l = 40000000000; // 5 GB
+class counting_bloom { // --counting-bloom. The bloom above, with 4-bit counters in place of bits, so that keys can be removed again
+	/*
+	 * Blocked in the same way, but a 512-bit block is 128 counters, and each probe takes 7
+	 * bits of the hash. A counter that reaches 15 stays there, as we no longer know how many
+	 * keys it counts; it just gives false positives from then on.
+	 * For the same rate of false positives, it needs four times the memory of a bloom.
+	 */
+	static const int64_t BLOCK_WORDS = 8; // 8 * 16 counters
+	static const int     PROBES = 4;
+	static const int64_t COUNTERS_PER_INSERTION = 16;
+	static const uint64_t SATURATED = 15;
+	vector<uint64_t> data;
+	uint64_t * blocks;
+	int64_t num_blocks;
+	counting_bloom(const counting_bloom &); // blocks points into data
+	counting_bloom & operator= (const counting_bloom &);
+	const uint64_t * block_for(const uint64_t h) const { return this->blocks + (h % this->num_blocks) * BLOCK_WORDS; }
+	      uint64_t * block_for(const uint64_t h)       { return this->blocks + (h % this->num_blocks) * BLOCK_WORDS; }
+public:
+	int64_t l; // the number of counters
+	int64_t occupied; // the counters that aren't zero
+	int64_t calls_to_set;
+	void clear(const int64_t expected_insertions) {
+		int64_t counters = max(int64_t(1), expected_insertions) * COUNTERS_PER_INSERTION;
+		if(counters > BLOOM_MAX_BITS / 4) // the same memory as the largest bloom
+			counters = BLOOM_MAX_BITS / 4;
+		if(global_memory_limit && counters > global_memory_limit / 2) // a quarter of the budget
+			counters = global_memory_limit / 2;
+		this->num_blocks = (counters + 16*BLOCK_WORDS - 1) / (16*BLOCK_WORDS);
+		this->l = this->num_blocks * 16*BLOCK_WORDS;
+		this->data.assign(this->num_blocks * BLOCK_WORDS + BLOCK_WORDS - 1, 0); // aligned as in bloom
+		this->blocks = cache_line_aligned(&this->data.front());
+		this->occupied = 0;
+		this->calls_to_set = 0;
+	}
+	counting_bloom() : blocks(NULL), num_blocks(0), l(0), occupied(0), calls_to_set(0) {
+		this->clear(0);
+	}
+	bloom_probe probe_for(const uint64_t a) const {
+		const uint64_t h = mix64(a);
+		const bloom_probe probe = { this->block_for(h), mix64(h ^ 0x9e3779b97f4a7c15ULL) };
+		return probe;
+	}
+	static void prefetch(const bloom_probe &probe) {
+		__builtin_prefetch(probe.block);
+	}
+	static bool test(const bloom_probe &probe) {
+		uint64_t bits = probe.bits;
+		for(int p = 0; p < PROBES; p++, bits >>= 7) {
+			const int counter = int(bits & 127);
+			unless((probe.block[counter >> 4] >> ((counter & 15) * 4)) & SATURATED)
+				return false;
+		}
+		return true;
+	}
+	bool test(const uint64_t a) const {
+		return test(this->probe_for(a));
+	}
+	void set(const uint64_t a) {
+		++ this->calls_to_set;
+		const uint64_t h = mix64(a);
+		uint64_t * block = this->block_for(h);
+		uint64_t bits = mix64(h ^ 0x9e3779b97f4a7c15ULL);
+		for(int p = 0; p < PROBES; p++, bits >>= 7) {
+			const int counter = int(bits & 127);
+			const int shift = (counter & 15) * 4;
+			const uint64_t count = (block[counter >> 4] >> shift) & SATURATED;
+			if(count == SATURATED)
+				continue;
+			if(count == 0)
+				++ this->occupied;
+			block[counter >> 4] += uint64_t(1) << shift;
+		}
+	}
+	void unset(const uint64_t a) { // a must have been set, and not yet unset
+		const uint64_t h = mix64(a);
+		uint64_t * block = this->block_for(h);
+		uint64_t bits = mix64(h ^ 0x9e3779b97f4a7c15ULL);
+		for(int p = 0; p < PROBES; p++, bits >>= 7) {
+			const int counter = int(bits & 127);
+			const int shift = (counter & 15) * 4;
+			const uint64_t count = (block[counter >> 4] >> shift) & SATURATED;
+			assert(count > 0);
+			if(count == SATURATED)
+				continue;
+			if(count == 1)
+				-- this->occupied;
+			block[counter >> 4] -= uint64_t(1) << shift;
+		}
+	}
+};
+template<typename Id, typename Filter = bloom>
 class intersecting_clique_finder { // based on a tree of all cliques, using a bloom filter to cut branch from the search tree
-	bloom bl;
-	int32_t num_cliques_in_here;
+	Filter bl;
+	Id num_cliques_in_here;
+	static uint64_t key(const Id branch_identifier, const int32_t node_id) { // one-to-one while the branch ids fit in 32 bits. Past that, a collision only costs a false positive
+		return (uint64_t(branch_identifier) << 32) + uint64_t(node_id) + (uint64_t(branch_identifier) >> 32);
+	}
 public:
-	const int32_t power_up; // the next power of two above the number of cliques
+	const Id power_up; // the next power of two above the number of cliques
 	double build_time; // seconds to construct
-	void rebuild(const vector<clique> &the_cliques
-			, const vector<int32_t> &the_clique_ids
-			, const comp & current_percolation_level
-			, const int32_t source_component_id)
+	static int64_t insertions_for(const Id power_up
+			, const clique_set &the_cliques
+			, const vector<Id> &the_clique_ids
+			, const comp<Id> & current_percolation_level
+			, const Id source_component_id)
 	{
-		const double pre_constructed = ELAPSED;
-		bl.clear();
+		int64_t expected_insertions = 0; // each clique's nodes go into every branch above its leaf, bar the root
+		int32_t depth = 0; // the number of levels, leaves included, below the root
+		for(Id p = power_up; p > 1; p >>= 1)
+			++ depth;
+		for(size_t x = 0; x < the_clique_ids.size(); x++) {
+			const Id c = the_clique_ids.at(x);
+			if(current_percolation_level.my_component_id(c) == source_component_id)
+				expected_insertions += int64_t(the_cliques.at(c).size()) * depth;
+		}
+		return expected_insertions;
+	}
+	void rebuild(const clique_set &the_cliques
+			, const vector<Id> &the_clique_ids
+			, const comp<Id> & current_percolation_level
+			, const Id source_component_id)
+	{
+		bl.clear(insertions_for(this->power_up, the_cliques, the_clique_ids, current_percolation_level, source_component_id));
 		this->num_cliques_in_here = 0;
+		this->add_the_cliques(the_cliques, the_clique_ids, current_percolation_level, source_component_id);
+	}
+	void add_the_cliques(const clique_set &the_cliques
+			, const vector<Id> &the_clique_ids
+			, const comp<Id> & current_percolation_level
+			, const Id source_component_id)
+	{
+		const double pre_constructed = ELAPSED;
 		// initialize with the cliques that have at least t members in them.
 		for(size_t x = 0; x < the_clique_ids.size(); x++) {
-			const int c = the_clique_ids.at(x);
+			const Id c = the_clique_ids.at(x);
 			if(current_percolation_level.my_component_id(c) == source_component_id) {
 				// we need this if during rebuilding, as sometimes the_clique_ids is obsolete (too large)
 				++ num_cliques_in_here;
@@ -276,10 +889,13 @@ public:
 		const double post_constructed = ELAPSED;
 		this->build_time = post_constructed - pre_constructed;
 	}
-	intersecting_clique_finder(const int32_t p, const vector<clique> &the_cliques, const vector<int32_t> &the_clique_ids, const comp & current_percolation_level, const int32_t source_component_id) : power_up(p) {
+	intersecting_clique_finder(const Id p, const clique_set &the_cliques, const vector<Id> &the_clique_ids, const comp<Id> & current_percolation_level, const Id source_component_id) : power_up(p) {
 		this->rebuild(the_cliques, the_clique_ids, current_percolation_level, source_component_id);
 	}
-	int32_t get_num_cliques_in_here() const {
+	intersecting_clique_finder(const Id p, const int64_t expected_insertions) : num_cliques_in_here(0), power_up(p), build_time(0) { // empty, to add_the_cliques() and remove_clique() with a counting_bloom
+		bl.clear(expected_insertions);
+	}
+	Id get_num_cliques_in_here() const {
 		return num_cliques_in_here;
 	}
 	void dump_state(const int32_t k) const {
@@ -292,25 +908,25 @@ public:
 			<< " construct_time=" << this->build_time << "s."
 			<< endl;
 	}
-	const bloom & get_bloom_filter(void) const { return this->bl; }
-	int32_t overlap_estimate(const clique &new_clique, const int32_t branch_identifier) const {
+	const Filter & get_bloom_filter(void) const { return this->bl; }
+	int32_t overlap_estimate(const clique &new_clique, const Id branch_identifier) const {
 		assert(branch_identifier > 1); // never call this on the root node, it hasn't been populated
 		int32_t potential_overlap = 0;
 		for(size_t n = 0; n < new_clique.size(); n++) {
 			const int32_t node_id = new_clique.at(n);
-			const int64_t a = (int64_t(branch_identifier) << 32) + node_id;
+			const uint64_t a = key(branch_identifier, node_id);
 			potential_overlap += this->bl.test(a) ? 1 : 0;
 		}
 		return potential_overlap;
 	}
-	int32_t overlap_estimate(const clique &new_clique, const int32_t branch_identifier, int32_t t) const {
+	int32_t overlap_estimate(const clique &new_clique, const Id branch_identifier, int32_t t) const {
 		assert(branch_identifier > 1); // never call this on the root node, it hasn't been populated
 		// we're interested *only* in whether the overlap is >= t. We'll short-circuit once the answer is known.
 		int32_t potential_overlap = 0;
 		const size_t sz = new_clique.size();
 		for(size_t n = 0; n < sz; n++) {
 			const int32_t node_id = new_clique.at(n);
-			const int64_t a = (int64_t(branch_identifier) << 32) + node_id;
+			const uint64_t a = key(branch_identifier, node_id);
 			potential_overlap += this->bl.test(a) ? 1 : 0;
 			if(potential_overlap >= t)
 				return t;
@@ -319,48 +935,87 @@ public:
 		}
 		return potential_overlap;
 	}
-	void add_clique_to_bloom(const clique &new_clique, int32_t branch_identifier) {
+	/* For iterative_search: reaches[b] is whether overlap_estimate(new_clique, branches[b], t)
+	 * would be t. Every probe of every branch is worked out, and prefetched, before any is
+	 * tested, so that their cache misses overlap rather than come one after another.
+	 * probes is the caller's scratch, so it's allocated just once.
+	 */
+	void branches_reaching(const clique &new_clique, const Id *branches, const int num_branches, const int32_t t, bool *reaches, vector<bloom_probe> &probes) const {
+		const size_t sz = new_clique.size();
+		if(probes.size() < num_branches * sz)
+			probes.resize(num_branches * sz);
+		for(int b = 0; b < num_branches; b++) {
+			assert(branches[b] > 1); // never the root, it hasn't been populated
+			for(size_t n = 0; n < sz; n++) {
+				probes[b * sz + n] = this->bl.probe_for(key(branches[b], new_clique[n]));
+				Filter :: prefetch(probes[b * sz + n]);
+			}
+		}
+		for(int b = 0; b < num_branches; b++) {
+			reaches[b] = false;
+			int32_t potential_overlap = 0;
+			for(size_t n = 0; n < sz; n++) {
+				potential_overlap += Filter :: test(probes[b * sz + n]) ? 1 : 0;
+				if(potential_overlap >= t) {
+					reaches[b] = true;
+					break;
+				}
+				if(potential_overlap + int32_t(sz - n - 1) < t)
+					break;
+			}
+		}
+	}
+	void add_clique_to_bloom(const clique &new_clique, Id branch_identifier) {
 		while(branch_identifier > 1) { // we shouldn't bother populating the root node
 			for(size_t n = 0; n < new_clique.size(); n++) {
 				const int32_t node_id = new_clique.at(n);
-				const int64_t a = (int64_t(branch_identifier) << 32) + node_id;
+				const uint64_t a = key(branch_identifier, node_id);
 				this->bl.set(a);
 			}
 			branch_identifier >>= 1;
 		}
 	}
+	void remove_clique(const clique &old_clique, Id branch_identifier) { // only with a counting_bloom. Undoes add_clique_to_bloom
+		-- this->num_cliques_in_here;
+		while(branch_identifier > 1) {
+			for(size_t n = 0; n < old_clique.size(); n++)
+				this->bl.unset(key(branch_identifier, old_clique.at(n)));
+			branch_identifier >>= 1;
+		}
+	}
 };
-struct too_many_cliques_exception : public std :: exception { };
 
+template<typename Id>
 class assigned_branches_t_private_data_members {
 public:
-	int32_t power_up;
-	int32_t number_of_cliques;
-	int32_t total_marked;
+	Id power_up;
+	Id number_of_cliques;
+	Id total_marked;
 	vector<bool> assigned_branches; // the branches where all subleaves have already been assigned. // the recursive search should stop immediately
 };
-struct assigned_branches_t : private assigned_branches_t_private_data_members {
+template<typename Id>
+struct assigned_branches_t : private assigned_branches_t_private_data_members<Id> {
 public:
-	int32_t num_valid_leaf_assigns; // this is public, to let us reset when we feel like it.
-	int32_t C2;
-	explicit assigned_branches_t(int32_t p, int32_t C) {
+	Id num_valid_leaf_assigns; // this is public, to let us reset when we feel like it.
+	Id C2;
+	explicit assigned_branches_t(Id p, Id C) {
 		this->num_valid_leaf_assigns = 0;
 		this->C2 = 0;
 		this->power_up = p;
 		this->number_of_cliques = C;
 		this->total_marked = 0;
-		assigned_branches.resize(2*power_up, false);
-		int total_premarked_as_invalid = 0;
-		for(int invalid_leaf = power_up + C; invalid_leaf < 2 * power_up; invalid_leaf++ ) {
-			int marked_this_time = this->mark_as_done(invalid_leaf);
+		this->assigned_branches.resize(2*this->power_up, false);
+		Id total_premarked_as_invalid = 0;
+		for(Id invalid_leaf = this->power_up + C; invalid_leaf < 2 * this->power_up; invalid_leaf++ ) {
+			Id marked_this_time = this->mark_as_done(invalid_leaf);
 			total_premarked_as_invalid += marked_this_time;
 		}
 		this->num_valid_leaf_assigns = 0;
 	}
-	const assigned_branches_t_private_data_members & get() const {
+	const assigned_branches_t_private_data_members<Id> & get() const {
 		return *this;
 	}
-	int32_t mark_as_done(const int32_t branch_id) {
+	Id mark_as_done(const Id branch_id) {
 		assert(branch_id >= this->power_up);
 		assert(this->assigned_branches.at(branch_id) == false);
 		if(this->assigned_branches.at(branch_id) == false) {
@@ -369,11 +1024,11 @@ public:
 		return this->mark_as_done_(branch_id);
 	}
 private:
-	int32_t mark_as_done_(const int32_t branch_id) {
+	Id mark_as_done_(const Id branch_id) {
 		assert(branch_id >= 0 && size_t(branch_id) < this->assigned_branches.size());
-		int32_t marked_this_time = 0;
+		Id marked_this_time = 0;
 		if(this->assigned_branches.at(branch_id) == false) {
-			++ total_marked;
+			++ this->total_marked;
 			this->assigned_branches.at(branch_id) = true;
 			++ marked_this_time;
 			if(branch_id > 1) { // all branches, but the root, will have a partner
@@ -387,40 +1042,256 @@ private:
 	}
 };
 
-static int32_t actual_overlap(const clique &old_clique, const clique &new_clique) ;
+static uint64_t clique_signature(const clique &cl) ;
+static bool overlap_at_least(const clique &l, const clique &r, const int32_t t) ;
+static bool signatures_allow_overlap(const clique &l, const uint64_t l_signature, const clique &r, const uint64_t r_signature, const int32_t t) ;
+
+template<typename Id>
+class inverted_index { // the exact alternative to the intersecting_clique_finder (--search=index). For each node, the cliques it's in
+	/*
+	 * Rebuilt for every source component, with the postings of just the cliques in it.
+	 * The neighbours of a clique are found by counting, over the postings of its nodes,
+	 * how often each other clique turns up. Cliques that have been assigned are dropped
+	 * from the postings the next time we pass over them.
+	 * Everything is allocated once per level and reused; the node-indexed ranges are
+	 * invalidated by bumping 'generation', rather than by clearing them.
+	 */
+	vector<Id> postings;            // grouped by node
+	vector<int64_t> postings_begin; // [node]
+	vector<int64_t> postings_end;   // [node], shrinks as assigned cliques are dropped
+	vector<int32_t> generation_of_node; // [node], the ranges are valid only if this == generation
+	int32_t generation;
+	vector<int32_t> hits; // [clique], always all zero between searches
+	vector<Id> touched;
+	vector< pair<int32_t, Id> > node_clique_pairs; // scratch, for rebuild
+	Id num_cliques_in_here;
+public:
+	const Id power_up;
+	inverted_index(const Id p, const clique_set &the_cliques, const Id C) : generation(0), hits(C, 0), num_cliques_in_here(0), power_up(p) { // for the cliques [0, C) of this level
+		int32_t N = 0;
+		for(Id c = 0; c < C; c++)
+			unless(the_cliques.at(c).empty())
+				N = max(N, the_cliques.at(c).back() + 1); // the cliques are sorted
+		this->postings_begin.resize(N);
+		this->postings_end.resize(N);
+		this->generation_of_node.resize(N, 0);
+	}
+	void rebuild(const clique_set &the_cliques
+			, const vector<Id> &the_clique_ids
+			, const comp<Id> & current_percolation_level
+			, const Id source_component_id)
+	{
+		++ this->generation;
+		this->num_cliques_in_here = 0;
+		this->node_clique_pairs.clear();
+		for(size_t x = 0; x < the_clique_ids.size(); x++) {
+			const Id c = the_clique_ids.at(x);
+			if(current_percolation_level.my_component_id(c) == source_component_id) {
+				++ this->num_cliques_in_here;
+				For(node, the_cliques.at(c))
+					this->node_clique_pairs.push_back(make_pair(*node, c));
+			}
+		}
+		sort(this->node_clique_pairs.begin(), this->node_clique_pairs.end());
+		this->postings.resize(this->node_clique_pairs.size());
+		for(size_t i = 0; i < this->node_clique_pairs.size(); i++) {
+			const int32_t node = this->node_clique_pairs.at(i).first;
+			if(i == 0 || this->node_clique_pairs.at(i-1).first != node) {
+				this->generation_of_node.at(node) = this->generation;
+				this->postings_begin.at(node) = i;
+			}
+			this->postings.at(i) = this->node_clique_pairs.at(i).second;
+			this->postings_end.at(node) = i+1;
+		}
+	}
+	void rebuild(clique_postings<Id> &every_clique) { // when the source component is every clique, and the postings were built during the enumeration
+		++ this->generation;
+		vector<int64_t> csr_begin;
+		every_clique.move_to_csr(csr_begin, this->postings);
+		assert(csr_begin.size() <= this->postings_begin.size() + 1);
+		for(size_t node = 0; node + 1 < csr_begin.size(); node++) {
+			if(csr_begin.at(node) == csr_begin.at(node+1))
+				continue;
+			this->generation_of_node.at(node) = this->generation;
+			this->postings_begin.at(node) = csr_begin.at(node);
+			this->postings_end.at(node) = csr_begin.at(node+1);
+		}
+		this->num_cliques_in_here = this->hits.size();
+	}
+	Id get_num_cliques_in_here() const {
+		return num_cliques_in_here;
+	}
+	void neighbours_of_one_clique(const clique_set &the_cliques
+			, const Id current_clique_id
+			, const int32_t t
+			, vector<Id> &cliques_found
+			, assigned_branches_t<Id> &assigned_branches
+			) {
+		const vector<bool> & assigned = assigned_branches.get().assigned_branches;
+		For(node, the_cliques.at(current_clique_id)) {
+			if(this->generation_of_node.at(*node) != this->generation)
+				continue; // no other clique in this source component has this node
+			int64_t i = this->postings_begin.at(*node);
+			int64_t & end = this->postings_end.at(*node);
+			while(i < end) {
+				const Id c = this->postings.at(i);
+				if(assigned.at(this->power_up + c)) { // drop it, for good
+					this->postings.at(i) = this->postings.at(--end);
+					continue;
+				}
+				++ i;
+				if(this->hits.at(c) == 0)
+					this->touched.push_back(c);
+				if(++ this->hits.at(c) == t) {
+					assert(overlap_at_least(the_cliques.at(c), the_cliques.at(current_clique_id), t));
+					cliques_found.push_back(c);
+					assigned_branches.mark_as_done(this->power_up + c); // just like recursive_search, so it won't be found twice
+				}
+			}
+		}
+		For(c, this->touched)
+			this->hits.at(*c) = 0;
+		this->touched.clear();
+	}
+};
+
 
+struct search_counters { // what the searches of the tree did, for one_k to report, and to decide when to rebuild
+	int64_t visits;          // the branches the search got to, bar the assigned ones
+	int64_t filter_passes;   // the filter tests, bar the root, that said the branch might hold a clique overlapping enough
+	int64_t pruned;          // ... and that said it doesn't
+	int64_t skipped;         // the filter tests saved: by the single-unassigned-child skip of recursive_search, or on the assigned children iterative_search doesn't test
+	int64_t dead_ends;       // branches that passed, bar the leaves, none of whose unassigned children passed
+	int64_t leaves;          // leaves that passed
+	int64_t other_source;    // ... but were in another source component
+	int64_t overlaps_passed; // the exact overlap checks of the rest
+	int64_t overlaps_failed;
+	int64_t rejected_by_signature; // ... of which the signatures alone were enough. See clique_signature
+	double search_seconds;   // finding the neighbours of the cliques, by the wall clock. Only timed for --search-stats
+	search_counters() : visits(0), filter_passes(0), pruned(0), skipped(0), dead_ends(0), leaves(0), other_source(0), overlaps_passed(0), overlaps_failed(0), rejected_by_signature(0), search_seconds(0) {}
+	double false_positive_rate() const { // of the passes, those that came to nothing at the next branch down, or in the overlap check
+		return this->filter_passes == 0 ? 0.0 : double(this->dead_ends + this->other_source + this->overlaps_failed) / this->filter_passes;
+	}
+	search_counters operator- (const search_counters &o) const { // e.g. since the start of a source component
+		search_counters d;
+		d.visits          = this->visits          - o.visits;
+		d.filter_passes   = this->filter_passes   - o.filter_passes;
+		d.pruned          = this->pruned          - o.pruned;
+		d.skipped         = this->skipped         - o.skipped;
+		d.dead_ends       = this->dead_ends       - o.dead_ends;
+		d.leaves          = this->leaves          - o.leaves;
+		d.other_source    = this->other_source    - o.other_source;
+		d.overlaps_passed = this->overlaps_passed - o.overlaps_passed;
+		d.overlaps_failed = this->overlaps_failed - o.overlaps_failed;
+		d.rejected_by_signature = this->rejected_by_signature - o.rejected_by_signature;
+		d.search_seconds  = this->search_seconds  - o.search_seconds;
+		return d;
+	}
+};
+static double wall_seconds() { // ELAPSED is CPU time, and clock() is a system call. This isn't
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+template<typename Id>
+struct search_scratch { // one_k's, reused by every search, so that they allocate nothing
+	vector<Id> branches; // iterative_search's stack
+	vector<bloom_probe> probes; // see branches_reaching
+	search_counters counters;
+	vector<uint64_t> signatures; // of every clique in the level, see clique_signature. Empty if they don't fit in --memory-limit
+};
+class search_stats_file { // --search-stats: a JSON array with an object for each k, each with an array of its source components
+	FILE * f;
+	const string file_name;
+	bool first_level;
+	bool first_source_component;
+	void counters(const search_counters &c) {
+		fprintf(this->f, "\"visited\": %lld, \"filter_passes\": %lld, \"pruned\": %lld, \"skipped\": %lld, \"dead_ends\": %lld"
+				", \"leaves\": %lld, \"other_source\": %lld, \"overlaps_passed\": %lld, \"overlaps_failed\": %lld, \"rejected_by_signature\": %lld, \"false_positive_rate\": %.6f, \"search_seconds\": %.6f"
+				, (long long)c.visits, (long long)c.filter_passes, (long long)c.pruned, (long long)c.skipped, (long long)c.dead_ends
+				, (long long)c.leaves, (long long)c.other_source, (long long)c.overlaps_passed, (long long)c.overlaps_failed, (long long)c.rejected_by_signature, c.false_positive_rate(), c.search_seconds);
+	}
+public:
+	explicit search_stats_file(const string &_file_name) : f(fopen(_file_name.c_str(), "w")), file_name(_file_name), first_level(true), first_source_component(true) {
+		if(!this->f) {
+			cerr << endl << "Couldn't create file \"" << this->file_name << "\". Exiting." << endl;
+			exit(1);
+		}
+		fprintf(this->f, "[");
+	}
+	~search_stats_file() {
+		fprintf(this->f, "\n]\n");
+		if(ferror(this->f) || fclose(this->f) != 0)
+			cerr << endl << "Warning: couldn't write all of \"" << this->file_name << "\"" << endl;
+	}
+	void start_level(const int32_t k) { // with the search, so that the files of --search=bloom and --search=bloom-recursive runs can be compared
+		fprintf(this->f, "%s\n{\"k\": %d, \"search\": \"%s\", \"counting_bloom\": %s, \"source_components\": ["
+				, this->first_level ? "" : ",", k, global_recursive_search ? "bloom-recursive" : "bloom", global_counting_bloom ? "true" : "false");
+		this->first_level = false;
+		this->first_source_component = true;
+	}
+	void source_component(const int64_t source_component_id, const int64_t cliques, const int64_t filter_size, const int64_t filter_occupied, const double build_seconds, const int32_t rebuilds, const search_counters &c) {
+		fprintf(this->f, "%s\n\t{\"id\": %lld, \"cliques\": %lld, \"filter_size\": %lld, \"filter_occupied\": %lld, \"build_seconds\": %.6f, \"rebuilds\": %d, "
+				, this->first_source_component ? "" : ","
+				, (long long)source_component_id, (long long)cliques, (long long)filter_size, (long long)filter_occupied, build_seconds, rebuilds);
+		this->counters(c);
+		fprintf(this->f, "}");
+		this->first_source_component = false;
+	}
+	void end_level(const int64_t cliques, const double seconds, const int64_t rebuilds, const search_counters &c) {
+		fprintf(this->f, "\n], \"cliques\": %lld, \"seconds\": %.6f, \"rebuilds\": %lld, ", (long long)cliques, seconds, (long long)rebuilds);
+		this->counters(c);
+		fprintf(this->f, "}");
+	}
+};
+static void open_search_stats_or_die(const char * file_name) {
+	assert(!global_search_stats);
+	global_search_stats = new search_stats_file(file_name);
+}
+static void close_search_stats() {
+	delete global_search_stats; // finishing the JSON
+	global_search_stats = NULL;
+}
+template<typename Id, typename Filter>
 struct args_to_recursive_search { // many of the args never change. May aswell just pass them once
-	const intersecting_clique_finder &search_tree;
-	const int32_t current_clique_id;
+	const intersecting_clique_finder<Id, Filter> &search_tree;
+	const Id current_clique_id;
 	const int32_t t;
-	const vector<clique> &the_cliques;
-	const clique &current_clique;
-	const comp * current_percolation_level;
-	const int32_t component_already_in; // i.e. the community we're merging into now
-	const int32_t source_component_id; // the component (i.e. k-1-level community we're pulling from. This is just needed for verification
-};
-static void recursive_search(
-		const int32_t branch_identifier
-		, const args_to_recursive_search &args
-		, vector<int32_t> &cliques_found
-		, assigned_branches_t &assigned_branches
+	const clique_set &the_cliques;
+	const clique current_clique;
+	const uint64_t * signatures; // see clique_signature. NULL if there are none, then it's straight to the merge
+	const uint64_t current_signature;
+	const comp<Id> * current_percolation_level;
+	const Id component_already_in; // i.e. the community we're merging into now
+	const Id source_component_id; // the component (i.e. k-1-level community we're pulling from. This is just needed for verification
+	search_scratch<Id> * const scratch;
+};
+template<typename Id, typename Filter>
+static bool recursive_search( // true if the branch got past its filter (or skipped to a child that did)
+		const Id branch_identifier
+		, const args_to_recursive_search<Id, Filter> &args
+		, vector<Id> &cliques_found
+		, assigned_branches_t<Id> &assigned_branches
 		) { /// args_to_ new recursive_search
 	if(assigned_branches.get().assigned_branches.at(branch_identifier) == true) {
-		return; // this clique is no longer available
+		return false; // this clique is no longer available
 	}
+	search_counters & counters = args.scratch->counters;
+	++ counters.visits;
 	if(branch_identifier >= args.search_tree.power_up) { // is a leaf node, but might be invalid
-		const int32_t leaf_clique_id = branch_identifier - args.search_tree.power_up;
+		const Id leaf_clique_id = branch_identifier - args.search_tree.power_up;
 		assert(size_t(leaf_clique_id) < args.the_cliques.size()); // the invalid leaves should be marked assigned already
 	}
 
 	assert(assigned_branches.get().assigned_branches.at(branch_identifier) == false);
 	{ //optional optimization. If exactly one subbranch is unassigned, then skip directly to it
 		if(branch_identifier < args.search_tree.power_up) {
-			const int32_t left_subnode_id = branch_identifier << 1;
+			const Id left_subnode_id = branch_identifier << 1;
 			assert(left_subnode_id >= 0);  // just in case the <<1 made it negative
-			const int32_t right_subnode_id = left_subnode_id + 1;
+			const Id right_subnode_id = left_subnode_id + 1;
 			if         (assigned_branches.get().assigned_branches.at(left_subnode_id)
 				&& !assigned_branches.get().assigned_branches.at(right_subnode_id)) {
+				++ counters.skipped;
 				return recursive_search(
 						right_subnode_id
 						, args
@@ -430,6 +1301,7 @@ static void recursive_search(
 			}
 			if         (!assigned_branches.get().assigned_branches.at(left_subnode_id)
 				&& assigned_branches.get().assigned_branches.at(right_subnode_id)) {
+				++ counters.skipped;
 				return recursive_search(
 						left_subnode_id
 						, args
@@ -445,9 +1317,11 @@ static void recursive_search(
 		const int32_t potential_overlap = args.search_tree.overlap_estimate(args.current_clique, branch_identifier, args.t);
 		if(potential_overlap < args.t) {
 			assert(potential_overlap == 0);
-			return;
+			++ counters.pruned;
+			return false;
 		} else
 			assert(potential_overlap == args.t);
+		++ counters.filter_passes;
 	}
 
 
@@ -458,12 +1332,13 @@ static void recursive_search(
 	//   - recursively search both child nodes
 
 	if(branch_identifier >= args.search_tree.power_up) { // is a leaf node
-		const int32_t leaf_clique_id = branch_identifier - args.search_tree.power_up;
+		++ counters.leaves;
+		const Id leaf_clique_id = branch_identifier - args.search_tree.power_up;
 		assert(leaf_clique_id >= 0);
 		assert(size_t(leaf_clique_id) < args.the_cliques.size());
 		assert(leaf_clique_id != args.current_clique_id);
 		{
-			const int32_t component_id_of_leaf = args.current_percolation_level->my_component_id(leaf_clique_id);
+			const Id component_id_of_leaf = args.current_percolation_level->my_component_id(leaf_clique_id);
 			assert(component_id_of_leaf != args.component_already_in);
 			if (component_id_of_leaf != args.source_component_id) {
 				/* this leaf is in a different source component
@@ -471,43 +1346,145 @@ static void recursive_search(
 				* .. this is unlikely (impossible?) to happen, now there's a different
 				* bloom for each source component.
 				*/
-				return; // not in the current source component
+				++ counters.other_source;
+				return true; // not in the current source component
 			}
 			// time to check if this clique really does have a big enough overlap
 			assert(component_id_of_leaf == args.source_component_id);
 		}
-		const int32_t actual = actual_overlap(args.the_cliques.at(leaf_clique_id), args.current_clique) ;
-		assert(actual < (int32_t)args.current_clique.size()); // we never allow it to test for a match with itself, did you forget to include the seed into the community?
-		if(actual >= args.t) {
+		const clique leaf_clique = args.the_cliques.at(leaf_clique_id);
+		if(args.signatures && !signatures_allow_overlap(leaf_clique, args.signatures[leaf_clique_id], args.current_clique, args.current_signature, args.t)) {
+			++ counters.rejected_by_signature;
+			++ counters.overlaps_failed;
+		} else if(overlap_at_least(leaf_clique, args.current_clique, args.t)) {
+			++ counters.overlaps_passed;
 			cliques_found.push_back(leaf_clique_id);
 			assigned_branches.mark_as_done(branch_identifier); // this is *critical* for speed (if not accuracy). it stops it checking frontier<>frontier links.
-		}
+		} else
+			++ counters.overlaps_failed;
 	} else { // not a leaf node. check subbranches
-		const int32_t left_subnode_id = branch_identifier << 1;
+		const Id left_subnode_id = branch_identifier << 1;
 		assert(left_subnode_id >= 0);  // just in case the <<1 made it negative
-		const int32_t right_subnode_id = left_subnode_id + 1;
+		const Id right_subnode_id = left_subnode_id + 1;
 		assert(right_subnode_id <= 2* args.search_tree.power_up);
 
-		recursive_search(left_subnode_id
+		const bool left_passed = recursive_search(left_subnode_id
 				, args
 				, cliques_found
 				, assigned_branches);
-		recursive_search(right_subnode_id
+		const bool right_passed = recursive_search(right_subnode_id
 				, args
 				, cliques_found
 				, assigned_branches);
+		if(!left_passed && !right_passed && branch_identifier > 1)
+			++ counters.dead_ends;
 	}
+	return true;
 }
 
-static void neighbours_of_one_clique(const vector<clique> &the_cliques
-		, const int32_t current_clique_id
-		, const comp & components
+/*
+ * The same search as recursive_search, from the root, with an explicit stack. It finds the
+ * same cliques, in the same order, but rather than testing one branch's filter at a time,
+ * it takes up to SEARCH_BATCH branches off the top of the stack and tests all their unassigned
+ * children together, with the probes prefetched (branches_reaching). The children that pass
+ * are pushed in reverse, so it's still depth-first and left-first. A leaf on top of the stack
+ * ends the batch, and is checked on its own, so the cliques are found in the same order.
+ */
+static const int SEARCH_BATCH = 8;
+static const int64_t REBUILD_WINDOW = 10000; // filter passes. See --rebuild.bloom in one_k
+static const double REBUILD_FALSE_POSITIVE_GROWTH = 1.2;
+template<typename Id, typename Filter>
+static void iterative_search(
+		const args_to_recursive_search<Id, Filter> &args
+		, vector<Id> &cliques_found
+		, assigned_branches_t<Id> &assigned_branches
+		) {
+	const vector<bool> & assigned = assigned_branches.get().assigned_branches;
+	const Id power_up = args.search_tree.power_up;
+	vector<Id> & stack = args.scratch->branches;
+	assert(stack.empty());
+	stack.push_back(1); // the root isn't populated, so it has nothing to pass
+	search_counters & counters = args.scratch->counters;
+	Id children[2 * SEARCH_BATCH];
+	bool reaches[2 * SEARCH_BATCH];
+	int first_child[SEARCH_BATCH + 1]; // [parent in the batch], into children
+	while(!stack.empty()) {
+		const Id branch_identifier = stack.back();
+		if(branch_identifier < power_up) { // a batch of branches, from the top of the stack down to the first leaf
+			int num_parents = 0;
+			int num_children = 0;
+			bool root_in_batch = false;
+			for(int b = 0; b < SEARCH_BATCH && !stack.empty() && stack.back() < power_up; b++) {
+				const Id branch = stack.back();
+				stack.pop_back();
+				if(assigned.at(branch))
+					continue; // since it was pushed, the search of its left sibling assigned the rest of it
+				++ counters.visits;
+				root_in_batch = root_in_batch || branch == 1;
+				first_child[num_parents++] = num_children;
+				const Id left_subnode_id = branch << 1;
+				assert(left_subnode_id >= 0);  // just in case the <<1 made it negative
+				for(Id child = left_subnode_id; child <= left_subnode_id + 1; child++)
+					if(assigned.at(child))
+						++ counters.skipped;
+					else
+						children[num_children++] = child;
+			}
+			first_child[num_parents] = num_children;
+			args.search_tree.branches_reaching(args.current_clique, children, num_children, args.t, reaches, args.scratch->probes);
+			for(int c = num_children - 1; c >= 0; c--)
+				if(reaches[c]) {
+					++ counters.filter_passes;
+					stack.push_back(children[c]);
+				} else
+					++ counters.pruned;
+			for(int parent = root_in_batch ? 1 : 0; parent < num_parents; parent++) { // the root would be first. It has no filter to pass
+				bool any = false;
+				for(int c = first_child[parent]; c < first_child[parent+1]; c++)
+					any = any || reaches[c];
+				unless(any)
+					++ counters.dead_ends;
+			}
+			continue;
+		}
+		stack.pop_back();
+		if(assigned.at(branch_identifier))
+			continue;
+		++ counters.visits;
+		++ counters.leaves; // a leaf, and its filter has passed
+		const Id leaf_clique_id = branch_identifier - power_up;
+		assert(size_t(leaf_clique_id) < args.the_cliques.size());
+		assert(leaf_clique_id != args.current_clique_id);
+		const Id component_id_of_leaf = args.current_percolation_level->my_component_id(leaf_clique_id);
+		assert(component_id_of_leaf != args.component_already_in);
+		if (component_id_of_leaf != args.source_component_id) {
+			++ counters.other_source;
+			continue; // not in the current source component
+		}
+		const clique leaf_clique = args.the_cliques.at(leaf_clique_id);
+		if(args.signatures && !signatures_allow_overlap(leaf_clique, args.signatures[leaf_clique_id], args.current_clique, args.current_signature, args.t)) {
+			++ counters.rejected_by_signature;
+			++ counters.overlaps_failed;
+		} else if(overlap_at_least(leaf_clique, args.current_clique, args.t)) {
+			++ counters.overlaps_passed;
+			cliques_found.push_back(leaf_clique_id);
+			assigned_branches.mark_as_done(branch_identifier);
+		} else
+			++ counters.overlaps_failed;
+	}
+}
+
+template<typename Id, typename Filter>
+static void neighbours_of_one_clique(const clique_set &the_cliques
+		, const Id current_clique_id
+		, const comp<Id> & components
 		, const int32_t t
-		, const int32_t current_component_id
-		, const int32_t source_component_id
-		, const intersecting_clique_finder & search_tree
-		, vector<int32_t> &cliques_found
-		, assigned_branches_t &assigned_branches
+		, const Id current_component_id
+		, const Id source_component_id
+		, const intersecting_clique_finder<Id, Filter> & search_tree
+		, vector<Id> &cliques_found
+		, assigned_branches_t<Id> &assigned_branches
+		, search_scratch<Id> &scratch
 		) {
 	// given:
 	//    - one clique,
@@ -518,56 +1495,173 @@ static void neighbours_of_one_clique(const vector<clique> &the_cliques
 	//    - the list of cliques adjacent to the clique (at least t nodes in common),
 	//    - BUT without the cliques that are already in the current component
 		assert(current_component_id == components.my_component_id(current_clique_id));
-		const int32_t root_node = 1; // if C==1, then this is also the only leaf node
+		const Id root_node = 1; // if C==1, then this is also the only leaf node
 		if(assigned_branches.get().assigned_branches.at(root_node) == false) { // otherwise, we've assigned everything and the algorithm can complete
-			args_to_recursive_search args = {
+			args_to_recursive_search<Id, Filter> args = {
 				search_tree
 				, current_clique_id
 				, t
 				, the_cliques
 				, the_cliques.at(current_clique_id)
+				, scratch.signatures.empty() ? NULL : &scratch.signatures.front()
+				, scratch.signatures.empty() ? 0 : scratch.signatures.at(current_clique_id)
 				, &components
 				, current_component_id
 				, source_component_id
+				, &scratch
 			};
-			recursive_search(
-				root_node
-				, args
-				, cliques_found
-				, assigned_branches
-				);
+			if(global_recursive_search)
+				recursive_search(
+					root_node
+					, args
+					, cliques_found
+					, assigned_branches
+					);
+			else
+				iterative_search(
+					args
+					, cliques_found
+					, assigned_branches
+					);
 		}
 }
 
-static void one_k (vector<int32_t> & found_communities
-		, vector<int32_t>  & source_components
-		, vector<maybe_available>  & members_of_the_source_components
-		, comp &current_percolation_level
+/*
+ * At the larger k, most source components have only a few cliques, and building a tree of
+ * filters (or an index) for each costs far more than the search. A source component of at
+ * most BRUTE_FORCE_MAX_CLIQUES cliques gets neither: each clique is checked against every
+ * clique in it that's still unassigned. They're checked in the order of their ids, just as
+ * the tree finds them, so the communities come out the same either way.
+ * Timed per source component, brute force was at least twice as fast up to 128 cliques on
+ * every test graph. Beyond that it depends on how dense the graph is: still ahead at 256 on
+ * the sparser ones, but behind on dense.txt.
+ */
+static const size_t BRUTE_FORCE_MAX_CLIQUES = 128;
+template<typename Id>
+static void neighbours_by_brute_force(const clique_set &the_cliques
+		, const Id current_clique_id
 		, const int32_t t
-		, const vector<clique> &the_cliques
-		, const int32_t power_up
-		, const int32_t C
+		, const vector<Id> &members_of_the_source_component
+		, const vector<uint64_t> &signatures
+		, const Id power_up
+		, vector<Id> &cliques_found
+		, assigned_branches_t<Id> &assigned_branches
+		) {
+	const clique current_clique = the_cliques.at(current_clique_id);
+	const uint64_t current_signature = signatures.empty() ? 0 : signatures.at(current_clique_id);
+	For(c, members_of_the_source_component) {
+		if(assigned_branches.get().assigned_branches.at(power_up + *c))
+			continue;
+		const clique candidate = the_cliques.at(*c);
+		if((signatures.empty() || signatures_allow_overlap(candidate, signatures.at(*c), current_clique, current_signature, t)) && overlap_at_least(candidate, current_clique, t)) {
+			cliques_found.push_back(*c);
+			assigned_branches.mark_as_done(power_up + *c); // just like recursive_search, so it won't be found twice
+		}
+	}
+}
+
+template<typename Id>
+static void one_k (vector<Id> & found_communities
+		, vector<Id>  & source_components
+		, vector< maybe_available<Id> >  & members_of_the_source_components
+		, comp<Id> &current_percolation_level
+		, const int32_t t
+		, const clique_set &the_cliques
+		, const Id power_up
+		, const Id C // the cliques in this level are all in [0, C)
+		, const bool verbose // false in the parallel tasks, there are far too many of them to print it all
+		, clique_postings<Id> *warm_postings // if not NULL, the postings for all the cliques, for --search=index. Consumed
 	     );
 
-static void do_clique_percolation_variant_5b(const int32_t min_k, const int32_t max_k, const int32_t max_k_to_percolate, const vector< clique > &the_cliques, const char * output_dir_name, const graph :: NetworkInterfaceConvertedToString *network) {
+/*
+ * The levels are written out on a background thread, while the next level is computed.
+ * A level to be written is just its found_communities and its comp, which nothing modifies
+ * once the level has been percolated; the writer takes ownership of the comp, and deletes it
+ * when it's done. At most max_levels_queued levels wait, plus the one being written. Beyond
+ * that, write() blocks, which bounds the memory held by the comps.
+ */
+template<typename Id>
+struct level_to_write {
+	int32_t k;
+	vector<Id> found_communities;
+	comp<Id> * level; // owned
+	level_to_write() : k(0), level(NULL) {}
+};
+template<typename Id>
+static void swap(level_to_write<Id> &l, level_to_write<Id> &r) { // bounded_queue moves items with swap()
+	std :: swap(l.k, r.k);
+	l.found_communities.swap(r.found_communities);
+	std :: swap(l.level, r.level);
+}
+template<typename Id>
+class background_level_writer : public threads :: runnable {
+	threads :: bounded_queue< level_to_write<Id> > q;
+	const char * output_dir_name;
+	const clique_set &the_cliques;
+	const output :: node_name_cache &names;
+	const run_identity * checkpoint_id; // if not NULL, checkpoint after each level
+	threads :: thread * writer;
+	background_level_writer(const background_level_writer &);
+	background_level_writer & operator= (const background_level_writer &);
+public:
+	background_level_writer(const char * _output_dir_name, const clique_set &_the_cliques, const output :: node_name_cache &_names, const run_identity * _checkpoint_id, size_t max_levels_queued = 2)
+		: q(max_levels_queued), output_dir_name(_output_dir_name), the_cliques(_the_cliques), names(_names), checkpoint_id(_checkpoint_id), writer(NULL) {
+		this->writer = start_thread_or_die(*this);
+	}
+	~background_level_writer() { // waits for everything to be written
+		this->q.close();
+		delete this->writer; // joins
+	}
+	void write(const int32_t k, const vector<Id> &found_communities, comp<Id> * level) { // takes ownership of level
+		level_to_write<Id> l;
+		l.k = k;
+		l.found_communities = found_communities;
+		l.level = level;
+		this->q.push(l);
+	}
+	virtual void run() {
+		level_to_write<Id> l;
+		while(this->q.pop(l)) {
+			write_all_communities_for_this_k(this->output_dir_name, l.k, l.found_communities, *l.level, this->the_cliques, this->names);
+			if(this->checkpoint_id) // the levels arrive in increasing order of k
+				write_checkpoint(this->output_dir_name, *this->checkpoint_id, l.k, *l.level, l.found_communities);
+			delete l.level;
+			l.level = NULL;
+		}
+	}
+};
+
+/*
+ * The cliques are sorted biggest first (see put_the_cliques_in_order), so the cliques with at
+ * least k nodes, the only ones in level k, are the first C_k ids. Each level's comp, and
+ * one_k's tree and assigned_branches, are sized for that prefix rather than for all C cliques,
+ * and the levels of large k, with few cliques, cost next to nothing.
+ * The cliques.bin of an older run, or of --incremental, isn't sorted. C_k then runs up to the
+ * last clique with k nodes, and the smaller cliques below that are skipped as before.
+ */
+template<typename Id>
+static void cliques_of_each_level(const clique_set &the_cliques, const int32_t max_k, vector<Id> &C_k) { // C_k[k], for k <= max_k: every clique with at least k nodes is below it
+	C_k.assign(max_k + 2, 0);
+	for(Id c = 0; c < Id(the_cliques.size()); c++)
+		C_k.at(min(int32_t(the_cliques.at(c).size()), max_k + 1)) = c + 1;
+	for(int32_t k = max_k; k >= 0; k--)
+		C_k.at(k) = max(C_k.at(k), C_k.at(k+1));
+}
+
+template<typename Id>
+static void do_clique_percolation_variant_5b(const int32_t min_k, const int32_t max_k, const int32_t max_k_to_percolate, const clique_set &the_cliques, const char * output_dir_name, const output :: node_name_cache &names, clique_postings<Id> &warm_postings, const run_identity &id, const checkpoint<Id> * resume_from) {
 	assert(max_k_to_percolate <= max_k);
 
-	assert(network);
 	assert(output_dir_name);
-	if(the_cliques.size() > static_cast<size_t>(std :: numeric_limits<int32_t> :: max())) {
-		throw too_many_cliques_exception();
-	}
-	const int32_t C = the_cliques.size();
+	const Id C = the_cliques.size();
 
 	PP4(C, min_k, max_k, max_k_to_percolate);
 	assert(min_k > 0 && min_k <= max_k && C >= 1);
 
-	int32_t power_up = 1; // this is to be the smallest power of 2 greater than, or equal to, the number of cliques
-	while(power_up < C)
-		power_up <<= 1;
-	assert(power_up > 0); // make sure it hasn't looped around and become negative!
-	PP2(C, power_up);
+	vector<Id> C_k;
+	cliques_of_each_level(the_cliques, max_k_to_percolate, C_k);
 	create_directory_for_output(output_dir_name);
+	background_level_writer<Id> writer(output_dir_name, the_cliques, names, &id);
 
 	/*
 	 * The above is generic to all k
@@ -586,14 +1680,30 @@ static void do_clique_percolation_variant_5b(const int32_t min_k, const int32_t
 	 */
 
 	// we seed the loop by setting up for k == min_k first
-	comp * current_percolation_level = NULL;
-	vector<int32_t> source_components;
-	vector<maybe_available> members_of_the_source_components; // the ids of the cliques in the source component
-	{ // for k==min_k, just put every clique into one source_component
-		current_percolation_level = new comp(C);
+	comp<Id> * current_percolation_level = NULL;
+	vector<Id> source_components;
+	vector< maybe_available<Id> > members_of_the_source_components; // the ids of the cliques in the source component
+	int32_t first_k = min_k;
+	if(resume_from) { // .. or for the level after the checkpoint, just as at the end of the main loop below
+		assert(resume_from->k >= min_k && resume_from->k < max_k_to_percolate);
+		first_k = resume_from->k + 1;
+		const comp<Id> checkpointed_level(resume_from->com, resume_from->num_components);
+		current_percolation_level = new comp<Id>(C_k.at(first_k));
+		source_components_for_the_next_level (
+				source_components
+				, members_of_the_source_components
+				, current_percolation_level
+				, first_k
+				, resume_from->found_communities
+				, &checkpointed_level
+				, the_cliques
+				);
+	} else { // for k==min_k, just put every clique into one source_component
+		assert(C_k.at(min_k) == C);
+		current_percolation_level = new comp<Id>(C);
 		source_components.push_back(0);
-		members_of_the_source_components.push_back( maybe_available() );
-		for(int c=0; c<C; c++) {
+		members_of_the_source_components.push_back( maybe_available<Id>() );
+		for(Id c=0; c<C; c++) {
 			members_of_the_source_components.at(0).insert(c);
 		}
 	}
@@ -603,13 +1713,19 @@ static void do_clique_percolation_variant_5b(const int32_t min_k, const int32_t
 	 * - the input is essentially the source_components object, this will be updated at the end of each loop.
 	 * - the output will be going into current_percolation_level, which again will be different at each loop.
 	 */
-	for(int32_t k = min_k; k<=max_k_to_percolate; k++) {
+	for(int32_t k = first_k; k<=max_k_to_percolate; k++) {
 		cout << endl << "Start processing for k = " << k << ". "
 			<< HOWLONG
 			<< "(" << memory_usage() << ")"
 			<< endl;
-		vector<int32_t> found_communities; // the component_ids of the communities that will be found
+		vector<Id> found_communities; // the component_ids of the communities that will be found
 		const int32_t t = k-1;
+		const Id cliques_in_this_level = C_k.at(k);
+		Id power_up = 1; // this is to be the smallest power of 2 greater than, or equal to, the number of cliques in this level
+		while(power_up < cliques_in_this_level)
+			power_up <<= 1;
+		assert(power_up > 0); // make sure it hasn't looped around and become negative!
+		PP2(cliques_in_this_level, power_up);
 
 		assert(members_of_the_source_components.size() > 0);
 		assert(t == k-1);
@@ -621,21 +1737,21 @@ static void do_clique_percolation_variant_5b(const int32_t min_k, const int32_t
 			, t
 			, the_cliques
 			, power_up
-			, C
+			, cliques_in_this_level
+			, true
+			, k == min_k ? &warm_postings : NULL
 			);
 		assert(source_components.size()==0);
 		assert(members_of_the_source_components.size()==0); // ensure everything has been consumed
 		/* The found communities are now in found_communities. Gotta write them out
 		 */
 		// PP4(__LINE__, "about to write", k, ELAPSED);
-		cout << "Found communities. About to write them: "; PP(ELAPSED);
-		write_all_communities_for_this_k(output_dir_name, k, found_communities, *current_percolation_level, the_cliques, network);
-		cout << "Written " << found_communities.size() << " communities for k = " << k << endl;
+		cout << "Found " << found_communities.size() << " communities for k = " << k << ". "; PP(ELAPSED);
 
 
 		const int32_t new_k = k + 1;
 		if(new_k > max_k_to_percolate) {
-			delete current_percolation_level;
+			writer.write(k, found_communities, current_percolation_level); // the writer will delete it
 			current_percolation_level = NULL;
 			break;
 		}
@@ -643,7 +1759,7 @@ static void do_clique_percolation_variant_5b(const int32_t min_k, const int32_t
 		/* Now, to check which communities (and cliques therein) are
 		 * suitable for passing up to the next level
 		 */
-		comp * new_percolation_level = new comp(C);
+		comp<Id> * new_percolation_level = new comp<Id>(C_k.at(new_k));
 
 		source_components.clear();
 		source_components_for_the_next_level (
@@ -656,32 +1772,506 @@ static void do_clique_percolation_variant_5b(const int32_t min_k, const int32_t
 				, the_cliques
 				);
 
-		swap(new_percolation_level, current_percolation_level);
-		delete new_percolation_level; // this is actually deleting the old_level, because of the swap on the immediately preceding line.
+		cout << "Writing them in the background. "; PP(ELAPSED);
+		writer.write(k, found_communities, current_percolation_level); // we're finished with it. The writer will delete it
+		current_percolation_level = new_percolation_level;
 		new_percolation_level = NULL;
+
 	}
 }
 
-static void one_k (vector<int32_t> & found_communities
-		, vector<int32_t> & source_components
-		, vector<maybe_available> & members_of_the_source_components
-		, comp &current_percolation_level
+/*
+ * --sweep: every k in one pass.
+ * At level k, two cliques (each of at least k nodes) are in the same community iff a chain
+ * of cliques joins them, each overlapping the next in at least k-1 nodes. So, if we join
+ * the overlapping pairs in decreasing order of overlap, with a union-find, the communities
+ * for k are simply the sets of the union-find, among the cliques of size >= k, once every
+ * pair with overlap >= k-1 has been joined. Going down from the largest k, each level just
+ * adds its own pairs to the union-find of the level above.
+ * The work is then proportional to the number of overlapping pairs, rather than to
+ * (number of levels * C) bloom trees and searches.
+ */
+template<typename Id>
+class union_find {
+	vector<Id> parent;
+	vector<Id> set_size;
+public:
+	explicit union_find(const Id N) : parent(N), set_size(N, 1) {
+		for(Id i = 0; i < N; i++)
+			this->parent.at(i) = i;
+	}
+	Id find(Id x) {
+		while(this->parent.at(x) != x) {
+			this->parent.at(x) = this->parent.at(this->parent.at(x)); // path halving
+			x = this->parent.at(x);
+		}
+		return x;
+	}
+	bool join(Id a, Id b) { // returns false if they were already together
+		a = this->find(a);
+		b = this->find(b);
+		if(a == b)
+			return false;
+		if(this->set_size.at(a) < this->set_size.at(b))
+			swap(a, b);
+		this->parent.at(b) = a;
+		this->set_size.at(a) += this->set_size.at(b);
+		return true;
+	}
+};
+template<typename Id>
+static void find_overlapping_pairs(const clique_set &the_cliques, clique_postings<Id> &every_clique, const int32_t min_overlap, vector< vector< pair<Id, Id> > > &pairs_by_overlap) {
+	// pairs_by_overlap[o] will be every pair (c,d), c<d, of cliques that share exactly o nodes, for o >= min_overlap
+	const Id C = the_cliques.size();
+	int32_t max_clique_size = 0;
+	for(Id c = 0; c < C; c++)
+		max_clique_size = max(max_clique_size, int32_t(the_cliques.at(c).size()));
+	pairs_by_overlap.clear();
+	pairs_by_overlap.resize(max_clique_size + 1);
+
+	// postings, in CSR form: for each node, the (increasing) ids of the cliques it's in
+	vector<int64_t> postings_begin;
+	vector<Id> postings;
+	every_clique.move_to_csr(postings_begin, postings);
+
+	vector<int32_t> hits(C, 0); // always all zero between cliques
+	vector<Id> touched;
+	for(Id c = 0; c < C; c++) {
+		For(node, the_cliques.at(c)) {
+			const typename vector<Id> :: const_iterator b = postings.begin() + postings_begin.at(*node);
+			const typename vector<Id> :: const_iterator e = postings.begin() + postings_begin.at(*node + 1);
+			for(typename vector<Id> :: const_iterator d = upper_bound(b, e, c); d != e; ++d) { // only d > c, so each pair is found once
+				if(hits.at(*d) ++ == 0)
+					touched.push_back(*d);
+			}
+		}
+		For(d, touched) {
+			const int32_t overlap = hits.at(*d);
+			if(overlap >= min_overlap)
+				pairs_by_overlap.at(overlap).push_back(make_pair(c, *d));
+			hits.at(*d) = 0;
+		}
+		touched.clear();
+	}
+}
+template<typename Id>
+static void do_clique_percolation_in_one_sweep(const int32_t min_k, const int32_t max_k_to_percolate, const clique_set &the_cliques, const char * output_dir_name, const output :: node_name_cache &names, clique_postings<Id> &warm_postings) {
+	assert(output_dir_name);
+	const Id C = the_cliques.size();
+	PP3(C, min_k, max_k_to_percolate);
+	assert(min_k > 0 && min_k <= max_k_to_percolate && C >= 1);
+	create_directory_for_output(output_dir_name);
+	background_level_writer<Id> writer(output_dir_name, the_cliques, names, NULL); // no checkpoints, as the levels come in decreasing order of k
+
+	vector< vector< pair<Id, Id> > > pairs_by_overlap; // [overlap]
+	find_overlapping_pairs(the_cliques, warm_postings, min_k-1, pairs_by_overlap);
+	{
+		int64_t num_pairs = 0;
+		For(pairs, pairs_by_overlap)
+			num_pairs += pairs->size();
+		cout << "Found " << thou(num_pairs) << " pairs of cliques overlapping in at least " << min_k-1 << " nodes. "
+			<< HOWLONG
+			<< "(" << memory_usage() << ")"
+			<< endl;
+	}
+
+	vector<Id> cliques_by_size; // biggest first. At level k, a prefix of this is the cliques with >= k nodes
+	for(Id c = 0; c < C; c++)
+		cliques_by_size.push_back(c);
+	stable_sort(cliques_by_size.begin(), cliques_by_size.end(), bigger_clique_first(the_cliques));
+
+	vector<Id> C_k;
+	cliques_of_each_level(the_cliques, max_k_to_percolate, C_k);
+	union_find<Id> uf(C);
+	Id num_big_enough = 0;
+	vector<Id> component_of_root(C, -1); // reset after each level, for just the roots we touched
+	for(int32_t k = max_k_to_percolate; k >= min_k; k--) {
+		cout << endl << "Start processing for k = " << k << ". "
+			<< HOWLONG
+			<< "(" << memory_usage() << ")"
+			<< endl;
+		for(int32_t overlap = k-1; overlap < int32_t(pairs_by_overlap.size()); overlap++) {
+			if(overlap > k-1 && k != max_k_to_percolate)
+				break; // the bigger overlaps were joined on the earlier levels
+			For(p, pairs_by_overlap.at(overlap))
+				uf.join(p->first, p->second);
+		}
+		while(num_big_enough < C && int32_t(the_cliques.at(cliques_by_size.at(num_big_enough)).size()) >= k)
+			++ num_big_enough;
+
+		// this level's sets, as a comp, so that we can write them out just like variant_5b
+		comp<Id> * level = new comp<Id>(C_k.at(k)); // cliques still in component 0 are too small for this k
+		vector<Id> found_communities;
+		for(Id i = 0; i < num_big_enough; i++) {
+			const Id c = cliques_by_size.at(i);
+			Id & component_id = component_of_root.at(uf.find(c));
+			if(component_id == -1) {
+				component_id = level->create_empty_component();
+				found_communities.push_back(component_id);
+			}
+			level->move_node(c, component_id, 0);
+		}
+		for(Id i = 0; i < num_big_enough; i++)
+			component_of_root.at(uf.find(cliques_by_size.at(i))) = -1;
+
+		cout << "Found " << found_communities.size() << " communities for k = " << k << ". Writing them in the background: "; PP(ELAPSED);
+		writer.write(k, found_communities, level);
+	}
+}
+
+/*
+ * --threads: the source components are independent of each other, so each becomes a task.
+ * A task is one (k-1)-community (at min_k, all the cliques), cut down to the cliques with at
+ * least k nodes. It's percolated on its own, by one_k, with the cliques renumbered from zero.
+ * Each k-community found is then immediately a task for k+1. The pool is a stack, so the
+ * workers go depth-first, and a community is refined all the way up before its siblings are
+ * started. That keeps the number of tasks waiting around small.
+ * The calling thread writes out level k as soon as every task at k, and below, has finished.
+ */
+template<typename Id>
+struct percolation_task {
+	int32_t k;
+	vector<Id> cliques; // ids into the_cliques, increasing
+};
+template<typename Id>
+static void copy_the_cliques_of_one_source_component(const clique_set &the_cliques, const percolation_task<Id> &task, clique_set &local_cliques, const string &spill_file_name) {
+	// task.cliques is increasing, so this reads the_cliques in order; that matters when it's mapped from disk.
+	int64_t total_nodes = 0;
+	For(c, task.cliques)
+		total_nodes += the_cliques.at(*c).size();
+	const int64_t bytes = sizeof(int64_t) * task.cliques.size() + sizeof(int32_t) * total_nodes;
+	if(global_memory_limit && bytes > global_memory_limit / 4) { // too big to hold. Put it on disk too
+		try {
+			clique_store :: clique_file_writer out(spill_file_name);
+			For(c, task.cliques)
+				out.push_back(the_cliques.at(*c));
+			out.close();
+			local_cliques.map_file(spill_file_name);
+		} catch (std :: runtime_error &e) {
+			cerr << endl << "Error: " << e.what() << ". Exiting." << endl;
+			exit(1);
+		}
+		remove(spill_file_name.c_str()); // the mapping stays valid
+		return;
+	}
+	local_cliques.reserve(task.cliques.size(), total_nodes);
+	For(c, task.cliques)
+		local_cliques.push_back(the_cliques.at(*c));
+}
+template<typename LocalId, typename Id>
+static void percolate_the_local_copy(const clique_set &local_cliques, const percolation_task<Id> &task, vector< vector<Id> > &communities) {
+	// one_k, on the cliques of one source component renumbered from zero. LocalId needs only be wide enough for those
+	const LocalId C_local = task.cliques.size();
+	LocalId power_up = 1;
+	while(power_up < C_local)
+		power_up <<= 1;
+
+	comp<LocalId> local_level(C_local);
+	vector<LocalId> source_components(1, 0);
+	vector< maybe_available<LocalId> > members_of_the_source_components(1);
+	for(LocalId c = 0; c < C_local; c++)
+		members_of_the_source_components.at(0).insert(c);
+	vector<LocalId> found_communities;
+	one_k(found_communities, source_components, members_of_the_source_components, local_level, task.k - 1, local_cliques, power_up, C_local, false, (clique_postings<LocalId> *) NULL);
+
+	map<LocalId, size_t> which_community; // component_id -> index into communities
+	For(f, found_communities) {
+		which_community[*f] = communities.size();
+		communities.push_back(vector<Id>());
+	}
+	for(LocalId c = 0; c < C_local; c++) // in increasing order, so each community's list is sorted too
+		communities.at(which_community.find(local_level.my_component_id(c))->second).push_back(task.cliques.at(c));
+}
+template<typename Id>
+static void percolate_one_source_component(const clique_set &the_cliques, const percolation_task<Id> &task, vector< vector<Id> > &communities, const string &spill_file_name) {
+	assert(communities.empty());
+	const Id C_local = task.cliques.size();
+	assert(C_local > 0);
+	if(C_local == 1) { // the common case, at the higher levels. No need for all the machinery
+		communities.push_back(task.cliques);
+		return;
+	}
+	clique_set local_copy;
+	const bool everything = size_t(C_local) == the_cliques.size(); // e.g. the first task. Then the ids are the same anyway
+	unless(everything)
+		copy_the_cliques_of_one_source_component(the_cliques, task, local_copy, spill_file_name);
+	const clique_set &local_cliques = everything ? the_cliques : local_copy;
+	if(small_enough_for_32_bit_ids(C_local)) // most of them are, even when the_cliques isn't
+		percolate_the_local_copy<int32_t>(local_cliques, task, communities);
+	else
+		percolate_the_local_copy<Id>(local_cliques, task, communities);
+}
+template<typename Id>
+class percolation_pool {
+	threads :: mutex m;
+	threads :: condition changed;
+	vector<percolation_task<Id> *> waiting; // a stack, for depth-first
+	int32_t running;
+	map<int32_t, int64_t> unfinished; // k -> number of tasks at this level not yet finished
+	map<int32_t, vector< vector<Id> > > found; // k -> communities found so far at this level
+	const string spill_dir; // if not empty, the communities go to a file per level instead of into found. See spill_file
+	map<int32_t, FILE *> spilled; // k -> that file
+public:
+	explicit percolation_pool(const string &_spill_dir = "") : running(0), spill_dir(_spill_dir) {}
+	~percolation_pool() {
+		For(t, this->waiting)
+			delete *t;
+		For(f, this->spilled)
+			fclose(f->second);
+	}
+	void add(percolation_task<Id> *task) {
+		threads :: lock l(this->m);
+		this->add_(task);
+	}
+	percolation_task<Id> * take() { // NULL when there's nothing left to do
+		threads :: lock l(this->m);
+		while(this->waiting.empty() && this->running > 0)
+			this->changed.wait(this->m);
+		if(this->waiting.empty())
+			return NULL;
+		percolation_task<Id> *task = this->waiting.back();
+		this->waiting.pop_back();
+		++ this->running;
+		return task;
+	}
+	void finish(const int32_t k, vector< vector<Id> > &communities, vector<percolation_task<Id> *> &next_tasks) {
+		threads :: lock l(this->m);
+		For(t, next_tasks) // these must be counted before this task is, or level k+1 might look finished
+			this->add_(*t);
+		next_tasks.clear();
+		if(this->spill_dir.empty()) {
+			vector< vector<Id> > &found_here = this->found[k];
+			For(comm, communities) {
+				found_here.push_back(vector<Id>());
+				found_here.back().swap(*comm);
+			}
+		} else {
+			FILE * f = this->spill_file(k);
+			For(comm, communities) { // each is its size, then its clique ids
+				const Id size = comm->size();
+				if(fwrite(&size, sizeof(size), 1, f) != 1 || fwrite(&comm->front(), sizeof(Id), size, f) != size_t(size)) {
+					cerr << endl << "Error: couldn't write the communities for k = " << k << " to \"" << this->spill_dir << "\". Exiting." << endl;
+					exit(1);
+				}
+			}
+			communities.clear();
+		}
+		-- this->unfinished[k];
+		-- this->running;
+		this->changed.broadcast();
+	}
+	void wait_for_level(const int32_t k, vector< vector<Id> > &communities) { // the levels below k must be done already
+		threads :: lock l(this->m);
+		while(this->unfinished[k] > 0)
+			this->changed.wait(this->m);
+		communities.swap(this->found[k]);
+		this->found.erase(k);
+	}
+	FILE * wait_for_spilled_level(const int32_t k) { // like wait_for_level, but with spill_dir. The caller must fclose it
+		threads :: lock l(this->m);
+		while(this->unfinished[k] > 0)
+			this->changed.wait(this->m);
+		FILE * f = this->spill_file(k);
+		this->spilled.erase(k);
+		rewind(f);
+		return f;
+	}
+private:
+	FILE * spill_file(const int32_t k) { // m must be locked
+		map<int32_t, FILE *> :: iterator it = this->spilled.find(k);
+		if(it != this->spilled.end())
+			return it->second;
+		ostringstream file_name;
+		file_name << this->spill_dir << "/communities" << k << ".tmp";
+		FILE * f = fopen(file_name.str().c_str(), "w+b");
+		if(!f) {
+			cerr << endl << "Error: couldn't create \"" << file_name.str() << "\". Exiting." << endl;
+			exit(1);
+		}
+		remove(file_name.str().c_str()); // it's gone for good on fclose, or if we crash
+		return this->spilled[k] = f;
+	}
+	void add_(percolation_task<Id> *task) {
+		++ this->unfinished[task->k];
+		this->waiting.push_back(task);
+		this->changed.broadcast();
+	}
+};
+template<typename Id>
+struct percolation_worker : public threads :: runnable {
+	const clique_set &the_cliques;
+	percolation_pool<Id> &pool;
+	const int32_t max_k_to_percolate;
+	const string spill_file_name; // for the cliques of a source component too big to copy into memory
+	percolation_worker(const clique_set &_the_cliques, percolation_pool<Id> &_pool, int32_t _max_k_to_percolate, const string &_spill_file_name)
+		: the_cliques(_the_cliques), pool(_pool), max_k_to_percolate(_max_k_to_percolate), spill_file_name(_spill_file_name) {}
+	virtual void run() {
+		while(percolation_task<Id> *task = this->pool.take()) {
+			vector< vector<Id> > communities;
+			percolate_one_source_component(this->the_cliques, *task, communities, this->spill_file_name);
+			vector<percolation_task<Id> *> next_tasks;
+			if(task->k < this->max_k_to_percolate) {
+				For(comm, communities) {
+					percolation_task<Id> *next = new percolation_task<Id>;
+					next->k = task->k + 1;
+					For(c, *comm)
+						if(int32_t(this->the_cliques.at(*c).size()) >= next->k)
+							next->cliques.push_back(*c);
+					if(next->cliques.empty())
+						delete next;
+					else
+						next_tasks.push_back(next);
+				}
+			}
+			this->pool.finish(task->k, communities, next_tasks);
+			delete task;
+		}
+	}
+};
+struct first_clique_first {
+	template<typename Id>
+	bool operator() (const vector<Id> &l, const vector<Id> &r) const {
+		return l.front() < r.front();
+	}
+};
+template<typename Id>
+static void read_spilled_level(FILE *f, comp<Id> &level, vector<Id> &found_communities) {
+	/* The communities are in the order they finished in, which depends on the scheduling.
+	 * Number them in that order as they're read, and then renumber them by their first
+	 * clique, as first_clique_first does for the communities held in memory.
+	 */
+	assert(level.component_count() == 1 && found_communities.empty());
+	vector< pair<Id, Id> > first_clique; // (first clique, component id as read)
+	Id size;
+	vector<Id> comm;
+	while(fread(&size, sizeof(size), 1, f) == 1) {
+		assert(size > 0);
+		comm.resize(size);
+		if(fread(&comm.front(), sizeof(Id), size, f) != size_t(size)) {
+			cerr << endl << "Error: couldn't read back the spilled communities. Exiting." << endl;
+			exit(1);
+		}
+		const Id component_id = level.create_empty_component();
+		first_clique.push_back(make_pair(comm.front(), component_id));
+		For(c, comm)
+			level.move_node(*c, component_id, 0);
+	}
+	sort(first_clique.begin(), first_clique.end());
+	vector<Id> renumbered(level.component_count(), 0); // [component id as read]
+	for(size_t x = 0; x < first_clique.size(); x++) {
+		renumbered.at(first_clique.at(x).second) = x + 1;
+		found_communities.push_back(x + 1);
+	}
+	const vector<Id> & com = level.get_com();
+	for(size_t c = 0; c < com.size(); c++) {
+		const Id from = com.at(c);
+		if(from != 0 && renumbered.at(from) != from)
+			level.move_node(c, renumbered.at(from), from);
+	}
+}
+template<typename Id>
+static void do_clique_percolation_in_parallel(const int32_t min_k, const int32_t max_k_to_percolate, const clique_set &the_cliques, const char * output_dir_name, const output :: node_name_cache &names, const int num_threads, const run_identity &id, const checkpoint<Id> * resume_from) {
+	assert(output_dir_name);
+	assert(num_threads >= 1);
+	const Id C = the_cliques.size();
+	PP4(C, min_k, max_k_to_percolate, num_threads);
+	assert(min_k > 0 && min_k <= max_k_to_percolate && C >= 1);
+	create_directory_for_output(output_dir_name);
+	background_level_writer<Id> writer(output_dir_name, the_cliques, names, &id, global_memory_limit ? 1 : 2);
+
+	percolation_pool<Id> pool(global_memory_limit ? output_dir_name : "");
+	int32_t first_k = min_k;
+	if(resume_from) { // each community in the checkpoint is a task for the next level
+		assert(resume_from->k >= min_k && resume_from->k < max_k_to_percolate);
+		first_k = resume_from->k + 1;
+		vector<percolation_task<Id> *> task_of_component(resume_from->num_components, (percolation_task<Id> *) NULL);
+		For(f, resume_from->found_communities) {
+			task_of_component.at(*f) = new percolation_task<Id>;
+			task_of_component.at(*f)->k = first_k;
+		}
+		for(Id c = 0; c < Id(resume_from->com.size()); c++) { // the checkpointed level's cliques. The rest are too small for it
+			percolation_task<Id> *task = task_of_component.at(resume_from->com.at(c));
+			if(task && int32_t(the_cliques.at(c).size()) >= first_k)
+				task->cliques.push_back(c);
+		}
+		For(task, task_of_component) {
+			if(*task && !(*task)->cliques.empty())
+				pool.add(*task);
+			else
+				delete *task;
+		}
+	} else {
+		percolation_task<Id> *everything = new percolation_task<Id>;
+		everything->k = min_k;
+		for(Id c = 0; c < C; c++)
+			everything->cliques.push_back(c); // they're all big enough for min_k
+		pool.add(everything);
+	}
+	vector<percolation_worker<Id> *> workers;
+	vector<threads :: thread *> running;
+	for(int t = 0; t < num_threads; t++) {
+		ostringstream spill_file_name;
+		spill_file_name << output_dir_name << "/component" << t << ".tmp";
+		workers.push_back(new percolation_worker<Id>(the_cliques, pool, max_k_to_percolate, spill_file_name.str()));
+		running.push_back(start_thread_or_die(*workers.back()));
+	}
+	vector<Id> C_k;
+	cliques_of_each_level(the_cliques, max_k_to_percolate, C_k);
+	for(int32_t k = first_k; k <= max_k_to_percolate; k++) {
+		comp<Id> * level = new comp<Id>(C_k.at(k)); // cliques still in component 0 are too small for this k
+		vector<Id> found_communities;
+		if(global_memory_limit) {
+			FILE * f = pool.wait_for_spilled_level(k);
+			read_spilled_level(f, *level, found_communities);
+			fclose(f);
+		} else {
+			vector< vector<Id> > communities;
+			pool.wait_for_level(k, communities);
+			sort(communities.begin(), communities.end(), first_clique_first()); // so the output doesn't depend on the scheduling
+			For(comm, communities) {
+				const Id component_id = level->create_empty_component();
+				found_communities.push_back(component_id);
+				For(c, *comm)
+					level->move_node(*c, component_id, 0);
+			}
+		}
+		cout << endl << "Finished percolating for k = " << k << ". "
+			<< HOWLONG
+			<< "(" << memory_usage() << ")"
+			<< endl;
+		cout << "Found " << found_communities.size() << " communities for k = " << k << ". Writing them in the background: "; PP(ELAPSED);
+		writer.write(k, found_communities, level);
+	}
+	for(int t = 0; t < num_threads; t++) {
+		delete running.at(t); // joins
+		delete workers.at(t);
+	}
+}
+
+template<typename Id>
+static void one_k (vector<Id> & found_communities
+		, vector<Id> & source_components
+		, vector< maybe_available<Id> > & members_of_the_source_components
+		, comp<Id> &current_percolation_level
 		, const int32_t t
-		, const vector<clique> &the_cliques
-		, const int32_t power_up
-		, const int32_t C
+		, const clique_set &the_cliques
+		, const Id power_up
+		, const Id C // the cliques in this level are all in [0, C)
+		, const bool verbose // false in the parallel tasks, there are far too many of them to print it all
+		, clique_postings<Id> *warm_postings // if not NULL, the postings for all the cliques, for --search=index. Consumed
 	     ) {
-	PP2(source_components.size(), members_of_the_source_components.size());
+	if(verbose)
+		PP2(source_components.size(), members_of_the_source_components.size());
 	/* We need a function that,
 	 *  - given a list of source components, where the small cliques have been kept out
 	 *  - does clique percolation on that, returning the component_ids of the found communities
 	 */
 	assert(found_communities.empty());
 
-	assigned_branches_t assigned_branches(power_up, C); // the branches where all subleaves have already been assigned.  the recursive search should stop immediately upon reaching one of these
-	int32_t C2 = 0; // the number of cliques that are big enough in this level, i.e. >= k nodes
+	assigned_branches_t<Id> assigned_branches(power_up, C); // the branches where all subleaves have already been assigned.  the recursive search should stop immediately upon reaching one of these
+	Id C2 = 0; // the number of cliques that are big enough in this level, i.e. >= k nodes
 	{ // all the cliques that are too small should be premarked as assigned
-		for(int c=0; c<C; c++) {
+		for(Id c=0; c<C; c++) {
 			const int32_t clique_size = the_cliques.at(c).size();
 			if(clique_size <= t) {
 				assigned_branches.mark_as_done(power_up + c);
@@ -692,30 +2282,97 @@ static void one_k (vector<int32_t> & found_communities
 	assigned_branches.num_valid_leaf_assigns = 0;
 	assigned_branches.C2 = C2;
 
+	std :: auto_ptr< inverted_index<Id> > index; // if NULL, use a bloom-filtered intersecting_clique_finder for each source component
+	if(global_search_with_index)
+		index.reset(new inverted_index<Id>(power_up, the_cliques, C));
+	/* --counting-bloom: rather than a new filter for each source component, one for the whole
+	 * level. Each source component's cliques are added when we get to it, and each clique is
+	 * removed again as soon as it's assigned, so the filter never holds an assigned clique, and
+	 * is empty again by the next source component. It needs no rebuilding, and it's sized for
+	 * the largest source component.
+	 */
+	std :: auto_ptr< intersecting_clique_finder<Id, counting_bloom> > counting_isf;
+	if(global_counting_bloom && !index.get()) {
+		int64_t most_insertions = 0;
+		for(size_t x = 0; x < source_components.size(); x++)
+			most_insertions = max(most_insertions, intersecting_clique_finder<Id, counting_bloom> :: insertions_for(power_up, the_cliques, members_of_the_source_components.at(x).get_all_members(), current_percolation_level, source_components.at(x)));
+		counting_isf.reset(new intersecting_clique_finder<Id, counting_bloom>(power_up, most_insertions));
+	}
+
 	int64_t move_count = 0;
+	search_scratch<Id> scratch; // and its counters, with the bloom-filtered tree, are a measure of how well it prunes. See --clique-order
+	if(!global_memory_limit || int64_t(sizeof(uint64_t)) * C <= global_memory_limit / 4) { // like the copies of the source components, a quarter of the budget
+		scratch.signatures.resize(C);
+		for(Id c=0; c<C; c++)
+			scratch.signatures.at(c) = clique_signature(the_cliques.at(c));
+	}
+	search_stats_file * const stats = verbose && !index.get() ? global_search_stats : NULL;
+	if(stats)
+		stats->start_level(t+1);
+	int64_t rebuilds_in_this_level = 0;
+	const size_t num_source_components = source_components.size();
+	int64_t brute_force_source_components = 0; // see neighbours_by_brute_force
 	assert (!source_components.empty());
-	int num_cliques_fully_processed = 0;
+	Id num_cliques_fully_processed = 0;
 	const double time_at_start_of_one_k = ELAPSED;
 	int integral_time_already_printed = 0;
 	while (!source_components.empty()) {
-		const int32_t num_assigned_at_the_start_of_this_source = assigned_branches.num_valid_leaf_assigns;
+		const Id num_assigned_at_the_start_of_this_source = assigned_branches.num_valid_leaf_assigns;
 		/* ie.  assigned_branches.num_valid_leaf_assigns - num_assigned_at_the_start_of_this_source
 		 * will tell us how many cliques have, so far, been assigned in this source.
 		 * By comparing that to num_cliques_in_this_source, we can see how far from the end we are
 		 */
 
 		assert(source_components.size() == members_of_the_source_components.size());
-		const int32_t source_component = source_components.back();
+		const Id source_component = source_components.back();
 		source_components.pop_back();
-		maybe_available & the_cliques_yet_to_be_assigned_in_this_source_component = members_of_the_source_components.back();
-		const int32_t num_cliques_in_this_source = the_cliques_yet_to_be_assigned_in_this_source_component.size();
+		maybe_available<Id> & the_cliques_yet_to_be_assigned_in_this_source_component = members_of_the_source_components.back();
+		const Id num_cliques_in_this_source = the_cliques_yet_to_be_assigned_in_this_source_component.size();
+		const bool brute_force = size_t(num_cliques_in_this_source) <= BRUTE_FORCE_MAX_CLIQUES;
+		const vector<Id> members_for_brute_force = brute_force ? the_cliques_yet_to_be_assigned_in_this_source_component.get_all_members() : vector<Id>(); // get_next() pops them as they're assigned
+		intersecting_clique_finder<Id, counting_bloom> * const counting = brute_force ? NULL : counting_isf.get();
 
 		/* A distinct intersecting_clique_finder for each source_component,
 		 * which can be wiped and rebuilt occasionally
 		 */
-		intersecting_clique_finder isf(power_up, the_cliques, the_cliques_yet_to_be_assigned_in_this_source_component.get_all_members(), current_percolation_level, source_component);
-		isf.dump_state(t+1);
-		assert(num_cliques_in_this_source == isf.get_num_cliques_in_here());
+		std :: auto_ptr< intersecting_clique_finder<Id> > isf;
+		if(brute_force) {
+			++ brute_force_source_components;
+		} else if(index.get() && warm_postings && !warm_postings->empty()) { // the first level is just one source component, with every clique
+			assert(num_cliques_in_this_source == C);
+			index->rebuild(*warm_postings);
+			assert(num_cliques_in_this_source == index->get_num_cliques_in_here());
+		} else if(index.get()) {
+			index->rebuild(the_cliques, the_cliques_yet_to_be_assigned_in_this_source_component.get_all_members(), current_percolation_level, source_component);
+			assert(num_cliques_in_this_source == index->get_num_cliques_in_here());
+		} else if(counting) {
+			assert(counting->get_num_cliques_in_here() == 0); // the last source component's cliques have all been removed
+			counting->add_the_cliques(the_cliques, the_cliques_yet_to_be_assigned_in_this_source_component.get_all_members(), current_percolation_level, source_component);
+			if(verbose)
+				counting->dump_state(t+1);
+			assert(num_cliques_in_this_source == counting->get_num_cliques_in_here());
+		} else {
+			isf.reset(new intersecting_clique_finder<Id>(power_up, the_cliques, the_cliques_yet_to_be_assigned_in_this_source_component.get_all_members(), current_percolation_level, source_component));
+			if(verbose)
+				isf->dump_state(t+1);
+			assert(num_cliques_in_this_source == isf->get_num_cliques_in_here());
+		}
+		const search_counters at_the_start_of_this_source = scratch.counters;
+		search_counters at_the_start_of_this_window = scratch.counters; // for the rebuilds, see below
+		double false_positive_rate_after_the_build = -1; // over the first window after it
+		int32_t rebuilds_in_this_source = 0;
+		int64_t filter_size = 0;
+		int64_t filter_occupied = 0;
+		double build_seconds = 0;
+		if(isf.get()) {
+			filter_size = isf->get_bloom_filter().l;
+			filter_occupied = isf->get_bloom_filter().occupied;
+			build_seconds = isf->build_time;
+		} else if(counting) {
+			filter_size = counting->get_bloom_filter().l;
+			filter_occupied = counting->get_bloom_filter().occupied;
+			build_seconds = counting->build_time;
+		}
 
 
 
@@ -726,17 +2383,19 @@ static void one_k (vector<int32_t> & found_communities
 			//   - make it the first 'frontier' clique
 			//   - keep adding it, and all its neighbours, to the community until the frontier is empty
 
-			const int32_t seed_clique = the_cliques_yet_to_be_assigned_in_this_source_component.get_next(current_percolation_level, source_component);
+			const Id seed_clique = the_cliques_yet_to_be_assigned_in_this_source_component.get_next(current_percolation_level, source_component);
 			assert(assigned_branches.get().assigned_branches.at(power_up + seed_clique) == false);
 			assert(the_cliques.at(seed_clique).size() > size_t(t));
 
-			stack< int32_t, vector<int32_t> > frontier_cliques;
+			stack< Id, vector<Id> > frontier_cliques;
 			frontier_cliques.push(seed_clique);
-			const int32_t component_to_grow_into = current_percolation_level.create_empty_component();
-			int32_t num_cliques_in_this_community = 0;
+			const Id component_to_grow_into = current_percolation_level.create_empty_component();
+			Id num_cliques_in_this_community = 0;
 
 			current_percolation_level.move_node(seed_clique, component_to_grow_into, source_component);
 			assigned_branches.mark_as_done(power_up + seed_clique);
+			if(counting)
+				counting->remove_clique(the_cliques.at(seed_clique), power_up + seed_clique);
 
 			++ num_cliques_in_this_community;
 			++ move_count;
@@ -745,41 +2404,70 @@ static void one_k (vector<int32_t> & found_communities
 			while(!frontier_cliques.empty()) {
 				// PP(frontier_cliques.size());
 				// PP2(assigned_branches.get().total_marked, 1048576 - assigned_branches.get().total_marked);
-				const int32_t popped_clique = frontier_cliques.top();
+				const Id popped_clique = frontier_cliques.top();
 				frontier_cliques.pop();
 
 				assert(assigned_branches.get().assigned_branches.at(power_up + popped_clique));
-				vector<int32_t> fresh_frontier_cliques_found;
-				const int32_t current_component_id = current_percolation_level.my_component_id(popped_clique);
+				vector<Id> fresh_frontier_cliques_found;
+				const Id current_component_id = current_percolation_level.my_component_id(popped_clique);
 				assert(current_component_id == component_to_grow_into);
 
-				// 350 -> 390  = .12
-				// 400 -> 420  = .08
-				// 440 -> 450  = .70
-				if(global_rebuild_occasionally){ // rebuild isf?
-					const int32_t num_cliques_remaining_in_this_source
+				/* --rebuild.bloom. The filter still has the nodes of the cliques assigned since it was
+				 * built, and the more of those there are, the more of the branches that pass it come to
+				 * nothing. The false positive rate (see search_counters) is measured over each window of
+				 * REBUILD_WINDOW passes, and once it's REBUILD_FALSE_POSITIVE_GROWTH times what it was in
+				 * the first window after the filter was built, it's rebuilt from the cliques left.
+				 * A rebuild costs about as much as the searches of the cliques left, so at least a
+				 * quarter of the filter's cliques must have gone since it was built.
+				 */
+				if(global_rebuild_occasionally && isf.get()
+						&& (scratch.counters - at_the_start_of_this_window).filter_passes >= REBUILD_WINDOW) { // rebuild isf?
+					const Id num_cliques_remaining_in_this_source
 						= num_cliques_in_this_source
 						- (assigned_branches.num_valid_leaf_assigns - num_assigned_at_the_start_of_this_source);
 					assert(num_cliques_remaining_in_this_source >= 0);
-					if(num_cliques_remaining_in_this_source > 100
-							&& 2*num_cliques_remaining_in_this_source < isf.get_num_cliques_in_here())
+					const double false_positive_rate = (scratch.counters - at_the_start_of_this_window).false_positive_rate();
+					at_the_start_of_this_window = scratch.counters;
+					if(false_positive_rate_after_the_build < 0)
+						false_positive_rate_after_the_build = false_positive_rate;
+					else if(num_cliques_remaining_in_this_source > 100
+							&& 4*num_cliques_remaining_in_this_source < 3*isf->get_num_cliques_in_here() // else the rebuild costs more than it saves
+							&& false_positive_rate > REBUILD_FALSE_POSITIVE_GROWTH * false_positive_rate_after_the_build)
 					{
-						cout << "We can rebuild you" << endl;
-						PP2(num_cliques_remaining_in_this_source, isf.get_num_cliques_in_here());
-		isf.rebuild(the_cliques, the_cliques_yet_to_be_assigned_in_this_source_component.get_all_members(), current_percolation_level, source_component);
-		isf.dump_state(t+1);
+						if(verbose) {
+							cout << "Rebuilding the filter, after a false positive rate of " << false_positive_rate << endl;
+							PP2(num_cliques_remaining_in_this_source, isf->get_num_cliques_in_here());
+						}
+						isf->rebuild(the_cliques, the_cliques_yet_to_be_assigned_in_this_source_component.get_all_members(), current_percolation_level, source_component);
+						if(verbose)
+							isf->dump_state(t+1);
+						build_seconds += isf->build_time;
+						++ rebuilds_in_this_source;
+						false_positive_rate_after_the_build = -1;
 					}
 				}
 
 
-				neighbours_of_one_clique(the_cliques, popped_clique, current_percolation_level, t, component_to_grow_into, source_component, isf, fresh_frontier_cliques_found, assigned_branches);
+				const double search_started = stats ? wall_seconds() : 0;
+				if(brute_force)
+					neighbours_by_brute_force(the_cliques, popped_clique, t, members_for_brute_force, scratch.signatures, power_up, fresh_frontier_cliques_found, assigned_branches);
+				else if(index.get())
+					index->neighbours_of_one_clique(the_cliques, popped_clique, t, fresh_frontier_cliques_found, assigned_branches);
+				else if(counting)
+					neighbours_of_one_clique(the_cliques, popped_clique, current_percolation_level, t, component_to_grow_into, source_component, *counting, fresh_frontier_cliques_found, assigned_branches, scratch);
+				else
+					neighbours_of_one_clique(the_cliques, popped_clique, current_percolation_level, t, component_to_grow_into, source_component, *isf, fresh_frontier_cliques_found, assigned_branches, scratch);
+				if(stats)
+					scratch.counters.search_seconds += wall_seconds() - search_started;
 				// int32_t search_successes = fresh_frontier_cliques_found.size();
 				// const int32_t old_size_of_growing_community = current_percolation_level.get_members(component_to_grow_into).size();
-				for(int x = 0; x < (int)fresh_frontier_cliques_found.size(); x++) {
-					const int32_t frontier_clique_to_be_moved_in = fresh_frontier_cliques_found.at(x);
+				for(size_t x = 0; x < fresh_frontier_cliques_found.size(); x++) {
+					const Id frontier_clique_to_be_moved_in = fresh_frontier_cliques_found.at(x);
 					frontier_cliques.push(frontier_clique_to_be_moved_in);
 					assert(source_component == current_percolation_level.my_component_id(frontier_clique_to_be_moved_in));
 					current_percolation_level.move_node(frontier_clique_to_be_moved_in, component_to_grow_into, source_component);
+					if(counting)
+						counting->remove_clique(the_cliques.at(frontier_clique_to_be_moved_in), power_up + frontier_clique_to_be_moved_in);
 					++num_cliques_in_this_community;
 					++ move_count;
 					/*
@@ -795,7 +2483,7 @@ static void one_k (vector<int32_t> & found_communities
 					++num_cliques_fully_processed;
 					const double time_now = ELAPSED;
 					const int integral_seconds_since_start_of_one_k = time_now - time_at_start_of_one_k;
-					if(integral_seconds_since_start_of_one_k > integral_time_already_printed)
+					if(verbose && integral_seconds_since_start_of_one_k > integral_time_already_printed)
 					// if(100 * num_cliques_fully_processed / C2 > 100 * (num_cliques_fully_processed-1) / C2)
 					{
 						integral_time_already_printed = integral_seconds_since_start_of_one_k;
@@ -817,11 +2505,32 @@ static void one_k (vector<int32_t> & found_communities
 		assert(num_cliques_in_this_source == assigned_branches.num_valid_leaf_assigns - num_assigned_at_the_start_of_this_source);
 		assert(the_cliques_yet_to_be_assigned_in_this_source_component.size()==0);
 		members_of_the_source_components.pop_back();
+		if(stats)
+			stats->source_component(source_component, num_cliques_in_this_source, filter_size, filter_occupied, build_seconds, rebuilds_in_this_source, scratch.counters - at_the_start_of_this_source);
+		rebuilds_in_this_level += rebuilds_in_this_source;
 	} // looping over the source components
-	PP2(t+1, ELAPSED - time_at_start_of_one_k);
-	PP2(C2, assigned_branches.num_valid_leaf_assigns);
+	if(stats)
+		stats->end_level(C2, ELAPSED - time_at_start_of_one_k, rebuilds_in_this_level, scratch.counters);
+	if(verbose) {
+		PP2(t+1, ELAPSED - time_at_start_of_one_k);
+		PP2(C2, assigned_branches.num_valid_leaf_assigns);
+		cout << thou(brute_force_source_components) << " of the " << thou(num_source_components) << " source components, of at most " << BRUTE_FORCE_MAX_CLIQUES << " cliques, were percolated by brute force" << endl;
+		unless(index.get()) {
+			const search_counters & c = scratch.counters;
+			cout << "The search for k = " << t+1 << " visited " << thou(c.visits) << " branches"
+				<< ". Filter tests: " << thou(c.filter_passes) << " passed, " << thou(c.pruned) << " pruned, " << thou(c.skipped) << " skipped"
+				<< ". Dead ends: " << thou(c.dead_ends)
+				<< ". Leaves: " << thou(c.leaves) << ", of which " << thou(c.overlaps_passed) << " overlapped, " << thou(c.overlaps_failed) << " didn't (" << thou(c.rejected_by_signature) << " by their signatures alone), and " << thou(c.other_source) << " were in another source component"
+				<< ". False positive rate: " << c.false_positive_rate()
+				<< ". Rebuilds: " << rebuilds_in_this_level;
+			if(stats)
+				cout << ". Searching took " << c.search_seconds << "s";
+			cout << endl;
+		}
+	}
 	assert(C2 == assigned_branches.num_valid_leaf_assigns);
 	assert(C2 == num_cliques_fully_processed);
+	assert(!counting_isf.get() || counting_isf->get_num_cliques_in_here() == 0);
 }
 
 template<typename T>
@@ -833,14 +2542,275 @@ string thou(T number) {
 }
 
 
-static int32_t actual_overlap(const clique &old_clique, const clique &new_clique) {
-	vector<int32_t> intersection;
-	set_intersection( old_clique.begin(), old_clique.end()
-	                 ,new_clique.begin(), new_clique.end()
-			 , back_inserter(intersection));
-	return intersection.size();
+/*
+ * The exact overlap check of the leaves, which is most of what the search does once the
+ * filters have passed. Each clique's signature has a bit set for each of its nodes, by a hash
+ * of the node, so two cliques' shared nodes all have their bits in both signatures. A clique
+ * with n nodes, but only b bits set, has n-b nodes that share a bit with another of its nodes,
+ * so the overlap is at most popcount(l & r) plus the fewer of those. When that's below t,
+ * there's no need to look at the nodes. The signatures take 8 bytes for each clique of the
+ * level, and with --memory-limit, if that's more than a quarter of the budget, one_k does
+ * without them.
+ * Otherwise, it's a merge of the two sorted cliques, stopping as soon as it has found t
+ * shared nodes, or there aren't enough nodes left in one of them to get to t.
+ */
+static uint64_t clique_signature(const clique &cl) {
+	uint64_t signature = 0;
+	For(node, cl)
+		signature |= uint64_t(1) << (mix64(*node) & 63);
+	return signature;
+}
+static bool overlap_at_least(const clique &l, const clique &r, const int32_t t) {
+	const int32_t * i = l.begin();
+	const int32_t * j = r.begin();
+	int32_t shared = 0;
+	while(shared + min(l.end() - i, r.end() - j) >= t) {
+		if(shared >= t)
+			return true;
+		if(*i < *j)
+			++ i;
+		else if(*j < *i)
+			++ j;
+		else {
+			++ shared;
+			++ i;
+			++ j;
+		}
+	}
+	return false;
+}
+static bool signatures_allow_overlap(const clique &l, const uint64_t l_signature, const clique &r, const uint64_t r_signature, const int32_t t) { // false if they can't share t nodes
+	const int32_t l_collisions = l.size() - __builtin_popcountll(l_signature);
+	const int32_t r_collisions = r.size() - __builtin_popcountll(r_signature);
+	return __builtin_popcountll(l_signature & r_signature) + min(l_collisions, r_collisions) >= t;
 }
 
+static threads :: thread * start_thread_or_die(threads :: runnable &r) { // the other threads may be waiting on this one, so there's no carrying on without it
+	try {
+		return new threads :: thread(r);
+	} catch (std :: runtime_error &e) {
+		cerr << endl << "Error: " << e.what() << ". Exiting." << endl;
+		exit(1);
+	}
+}
+static void check_loaded_cliques_or_die(const clique_set &the_cliques, const int32_t min_k, const int32_t num_nodes, const string &file_name) { // it might be from another graph, or another -k
+	for(size_t c = 0; c < the_cliques.size(); c++) {
+		const clique cl = the_cliques.at(c);
+		if(int32_t(cl.size()) < min_k) {
+			cerr << endl << "Error: \"" << file_name << "\" has a clique of " << cl.size() << " nodes, smaller than -k " << min_k << ". Were the cliques saved with a smaller -k? Exiting." << endl;
+			exit(1);
+		}
+		for(size_t i = 0; i < cl.size(); i++)
+			unless(cl[i] >= 0 && cl[i] < num_nodes && (i == 0 || cl[i-1] < cl[i])) {
+				cerr << endl << "Error: \"" << file_name << "\" has a clique with nodes that aren't in this graph, or aren't in order. Were the cliques saved from another edge list? Exiting." << endl;
+				exit(1);
+			}
+	}
+}
+static FILE * open_for_writing_or_die(const string &file_name) {
+	FILE * f = fopen(file_name.c_str(), "w");
+	if(!f) {
+		cerr << endl << "Couldn't create file \"" << file_name << "\". Exiting." << endl;
+		exit(1);
+	}
+	return f;
+}
+static uint64_t fnv1a(const void *p, const size_t n, uint64_t h = 14695981039346656037ULL) { // http://en.wikipedia.org/wiki/Fowler-Noll-Vo_hash_function
+	const unsigned char * bytes = static_cast<const unsigned char *>(p);
+	for(size_t i = 0; i < n; i++) {
+		h ^= bytes[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+static uint64_t hash_of_file_or_die(const char * file_name) {
+	FILE * f = fopen(file_name, "rb");
+	if(!f) {
+		cerr << endl << "Couldn't read \"" << file_name << "\". Exiting." << endl;
+		exit(1);
+	}
+	uint64_t h = fnv1a(NULL, 0);
+	vector<char> buf(1 << 20);
+	size_t got;
+	while((got = fread(&buf.front(), 1, buf.size(), f)) > 0)
+		h = fnv1a(&buf.front(), got, h);
+	fclose(f);
+	return h;
+}
+static uint64_t hash_of_cliques(const clique_set &the_cliques) {
+	uint64_t h = fnv1a(NULL, 0);
+	for(size_t c = 0; c < the_cliques.size(); c++) {
+		const clique cl = the_cliques.at(c);
+		const int64_t size = cl.size();
+		h = fnv1a(&size, sizeof(size), h);
+		unless(cl.empty())
+			h = fnv1a(cl.begin(), sizeof(int32_t) * cl.size(), h);
+	}
+	return h;
+}
+/* <output_dir>/checkpoint, in the native byte order:
+ *  - the 8 magic bytes "CP5CKPT2"
+ *  - uint64: graph_hash, uint64: cliques_hash
+ *  - int32: min_k, k, id_bytes (4 or 8, the width of the ids below), 0
+ *  - int64: num_components, C
+ *  - id * C: com, for the cliques up to the last one with k nodes. That's not all of them
+ *  - int64: F
+ *  - id * F: found_communities
+ * It's written to checkpoint.tmp, then renamed over the old one, so a crash leaves one or the other.
+ * A "CP5CKPT1" checkpoint, from before there were 64-bit ids, is all int32 after the hashes:
+ * min_k, k, num_components, C, com, F and found_communities. It can still be resumed.
+ */
+static void write_or_die(FILE *f, const void *p, const size_t n, const string &file_name) {
+	if(n > 0 && fwrite(p, 1, n, f) != n) {
+		cerr << endl << "Couldn't write to \"" << file_name << "\". Exiting." << endl;
+		exit(1);
+	}
+}
+template<typename Id>
+static void write_checkpoint(const char * output_dir_name, const run_identity &id, const int32_t k, const comp<Id> &level, const vector<Id> &found_communities) {
+	const string file_name = string(output_dir_name) + "/checkpoint";
+	const string tmp_file_name = file_name + ".tmp";
+	FILE * f = open_for_writing_or_die(tmp_file_name);
+	const vector<Id> & com = level.get_com();
+	const int32_t header[4] = { id.min_k, k, int32_t(sizeof(Id)), 0 };
+	const int64_t sizes[2] = { level.component_count(), int64_t(com.size()) };
+	const int64_t F = found_communities.size();
+	write_or_die(f, "CP5CKPT2", 8, tmp_file_name);
+	write_or_die(f, &id.graph_hash, sizeof(id.graph_hash), tmp_file_name);
+	write_or_die(f, &id.cliques_hash, sizeof(id.cliques_hash), tmp_file_name);
+	write_or_die(f, header, sizeof(header), tmp_file_name);
+	write_or_die(f, sizes, sizeof(sizes), tmp_file_name);
+	unless(com.empty())
+		write_or_die(f, &com.front(), sizeof(Id) * com.size(), tmp_file_name);
+	write_or_die(f, &F, sizeof(F), tmp_file_name);
+	unless(found_communities.empty())
+		write_or_die(f, &found_communities.front(), sizeof(Id) * F, tmp_file_name);
+	if(fflush(f) != 0 || fsync(fileno(f)) != 0 || fclose(f) != 0) {
+		cerr << endl << "Couldn't write to \"" << tmp_file_name << "\". Exiting." << endl;
+		exit(1);
+	}
+	if(rename(tmp_file_name.c_str(), file_name.c_str()) != 0) {
+		cerr << endl << "Couldn't rename \"" << tmp_file_name << "\" to \"" << file_name << "\". Exiting." << endl;
+		exit(1);
+	}
+}
+static void read_or_die(FILE *f, void *p, const size_t n, const string &file_name) {
+	if(n > 0 && fread(p, 1, n, f) != n) {
+		cerr << endl << "\"" << file_name << "\" is truncated. Exiting." << endl;
+		exit(1);
+	}
+}
+template<typename Id, typename Stored>
+static void read_ids_as_or_die(FILE *f, vector<Id> &ids, const string &file_name) { // fills ids, which is already sized, from Stored ids in the file
+	if(sizeof(Stored) == sizeof(Id)) {
+		unless(ids.empty())
+			read_or_die(f, &ids.front(), sizeof(Id) * ids.size(), file_name);
+		return;
+	}
+	vector<Stored> buf(1 << 16);
+	for(size_t done = 0; done < ids.size(); ) {
+		const size_t n = min(buf.size(), ids.size() - done);
+		read_or_die(f, &buf.front(), sizeof(Stored) * n, file_name);
+		for(size_t i = 0; i < n; i++) {
+			if(Stored(Id(buf.at(i))) != buf.at(i)) {
+				cerr << endl << "\"" << file_name << "\" has ids too big for " << 8 * sizeof(Id) << " bits. Exiting." << endl;
+				exit(1);
+			}
+			ids.at(done + i) = buf.at(i);
+		}
+		done += n;
+	}
+}
+template<typename Id>
+static void read_ids_or_die(FILE *f, vector<Id> &ids, const int32_t id_bytes, const string &file_name) {
+	if(id_bytes == 4)
+		read_ids_as_or_die<Id, int32_t>(f, ids, file_name);
+	else
+		read_ids_as_or_die<Id, int64_t>(f, ids, file_name);
+}
+static FILE * read_checkpoint_header_or_die(const char * output_dir_name, checkpoint_header &ck) {
+	const string file_name = string(output_dir_name) + "/checkpoint";
+	FILE * f = fopen(file_name.c_str(), "rb");
+	if(!f) {
+		cerr << endl << "Couldn't open \"" << file_name << "\". Is that the output directory of a cp5 run? Exiting." << endl;
+		exit(1);
+	}
+	char magic[8];
+	read_or_die(f, magic, sizeof(magic), file_name);
+	ck.version = memcmp(magic, "CP5CKPT1", 8) == 0 ? 1 : 2;
+	if(ck.version == 2 && memcmp(magic, "CP5CKPT2", 8) != 0) {
+		cerr << endl << "\"" << file_name << "\" isn't a cp5 checkpoint. Exiting." << endl;
+		exit(1);
+	}
+	read_or_die(f, &ck.id.graph_hash, sizeof(ck.id.graph_hash), file_name);
+	read_or_die(f, &ck.id.cliques_hash, sizeof(ck.id.cliques_hash), file_name);
+	int32_t header[4];
+	read_or_die(f, header, sizeof(header), file_name);
+	ck.id.min_k = header[0];
+	ck.k = header[1];
+	if(ck.version == 1) {
+		ck.id_bytes = 4;
+		ck.num_components = header[2];
+		ck.C = header[3];
+	} else {
+		ck.id_bytes = header[2];
+		int64_t sizes[2];
+		read_or_die(f, sizes, sizeof(sizes), file_name);
+		ck.num_components = sizes[0];
+		ck.C = sizes[1];
+	}
+	if(ck.C < 0 || (ck.id_bytes != 4 && ck.id_bytes != 8)) {
+		cerr << endl << "\"" << file_name << "\" is corrupt. Exiting." << endl;
+		exit(1);
+	}
+	return f;
+}
+template<typename Id>
+static void read_checkpoint_or_die(const char * output_dir_name, checkpoint<Id> &ck) {
+	const string file_name = string(output_dir_name) + "/checkpoint";
+	FILE * f = read_checkpoint_header_or_die(output_dir_name, ck);
+	ck.com.resize(ck.C);
+	read_ids_or_die(f, ck.com, ck.id_bytes, file_name);
+	int64_t F;
+	if(ck.version == 1) {
+		int32_t F32;
+		read_or_die(f, &F32, sizeof(F32), file_name);
+		F = F32;
+	} else
+		read_or_die(f, &F, sizeof(F), file_name);
+	if(F < 0) {
+		cerr << endl << "\"" << file_name << "\" is corrupt. Exiting." << endl;
+		exit(1);
+	}
+	ck.found_communities.resize(F);
+	read_ids_or_die(f, ck.found_communities, ck.id_bytes, file_name);
+	fclose(f);
+	For(c, ck.com)
+		if(*c < 0 || *c >= ck.num_components) {
+			cerr << endl << "\"" << file_name << "\" is corrupt. Exiting." << endl;
+			exit(1);
+		}
+}
+static void save_cliques_or_die(const clique_set &the_cliques, const string &file_name) {
+	try {
+		the_cliques.save(file_name);
+	} catch (std :: runtime_error &e) {
+		cerr << endl << "Error: " << e.what() << ". Exiting." << endl;
+		exit(1);
+	}
+}
+static void save_node_names_or_die(const output :: node_name_cache &names, const string &file_name) { // one per line, by node id. cliques.bin is in terms of those ids
+	FILE * f = open_for_writing_or_die(file_name);
+	{
+		output :: buffered_writer out(f);
+		for(int32_t n = 0; n < names.numNodes(); n++) {
+			out.append_name(names, n);
+			out.put('\n');
+		}
+		out.flush();
+	}
+	fclose(f);
+}
 static void create_directory_for_output(const char *dir) {
 	assert(dir);
 	{
@@ -851,99 +2821,226 @@ static void create_directory_for_output(const char *dir) {
 		}
 	}
 }
-static void write_all_communities_for_this_k(const char * output_dir_name
-		, const int32_t k
-		, const vector<int32_t> &found_communities
-		, const comp & current_percolation_level
-		, const vector<clique> &the_cliques
-		, const graph :: NetworkInterfaceConvertedToString *network
-		) {
-			const int32_t C = the_cliques.size();
-			map<int32_t, tr1 :: unordered_set<int32_t> > node_ids_in_each_community;
-			map<int32_t, tr1 :: unordered_set<int32_t> > clique_ids_in_each_community;
-			{
-				for(int32_t f = 0; f < (int32_t) found_communities.size(); f++) { // communities
-					const int32_t found_community_component_id = found_communities.at(f);
-					node_ids_in_each_community[found_community_component_id];
-					clique_ids_in_each_community[found_community_component_id];
+/*
+ * Writing out one level:
+ *  - the cliques are bucketed by community with a counting sort, so each community's cliques
+ *    are contiguous (and in increasing order);
+ *  - each community's distinct nodes are collected with a marker array, stamped with a
+ *    generation number so it never needs clearing, and only those are sorted;
+ *  - consecutive ranges of communities are rendered into memory, on several threads if
+ *    --threads, and then written out, in order, in large sequential writes.
+ * With --binary-output, percolated_cliques<k> isn't written. Instead, percolated_cliques<k>.bin
+ * lists the clique ids (see cliques.bin) of each community, rather than all their node names.
+ */
+template<typename Id>
+struct communities_of_one_level {
+	vector<int64_t> begin; // F+1 entries. Community f is made of cliques[begin[f], begin[f+1])
+	vector<Id> cliques;
+	Id size() const { return Id(this->begin.size()) - 1; }
+};
+template<typename Id>
+static void bucket_cliques_by_community(const vector<Id> &found_communities, const comp<Id> & current_percolation_level, communities_of_one_level<Id> &communities) {
+	const vector<Id> & com = current_percolation_level.get_com();
+	vector<Id> sorted_component_ids(found_communities);
+	sort(sorted_component_ids.begin(), sorted_component_ids.end()); // communities are written in order of component id
+	vector<Id> which_community(current_percolation_level.component_count(), -1); // [component id]
+	for(size_t f = 0; f < sorted_component_ids.size(); f++)
+		which_community.at(sorted_component_ids.at(f)) = f;
+	const Id F = sorted_component_ids.size();
+	communities.begin.assign(F+1, 0);
+	For(component_id, com) {
+		const Id f = which_community.at(*component_id);
+		if(f != -1)
+			++ communities.begin.at(f+1);
+	}
+	for(Id f = 0; f < F; f++)
+		communities.begin.at(f+1) += communities.begin.at(f);
+	communities.cliques.resize(communities.begin.at(F));
+	vector<int64_t> next(communities.begin.begin(), communities.begin.end() - 1);
+	for(size_t c = 0; c < com.size(); c++) {
+		const Id f = which_community.at(com.at(c));
+		if(f != -1)
+			communities.cliques.at(next.at(f)++) = c;
+	}
+}
+struct rendered_communities { // the text for a range of communities, waiting to be written
+	output :: text_buffer comm;
+	output :: text_buffer percolated_cliques;
+};
+template<typename Id>
+class community_renderer { // one per thread, for the marker array
+	const clique_set &the_cliques;
+	const output :: node_name_cache &names;
+	const communities_of_one_level<Id> &communities;
+	const bool with_percolated_cliques;
+	vector<uint32_t> marker; // [node]. == generation if the node has been seen in the current community
+	uint32_t generation;
+	vector<int32_t> nodes; // scratch
+public:
+	community_renderer(const clique_set &_the_cliques, const output :: node_name_cache &_names, const communities_of_one_level<Id> &_communities, bool _with_percolated_cliques)
+		: the_cliques(_the_cliques), names(_names), communities(_communities), with_percolated_cliques(_with_percolated_cliques)
+		, marker(_names.numNodes(), 0), generation(0) {}
+	void render(const Id first_community, const Id last_community, rendered_communities &out) {
+		for(Id f = first_community; f < last_community; f++) {
+			if(++ this->generation == 0) { // wrapped around, after 4 billion communities
+				fill(this->marker.begin(), this->marker.end(), 0);
+				this->generation = 1;
+			}
+			this->nodes.clear();
+			for(int64_t i = this->communities.begin.at(f); i < this->communities.begin.at(f+1); i++) {
+				For(node_id, this->the_cliques.at(this->communities.cliques.at(i))) {
+					if(this->marker.at(*node_id) != this->generation) {
+						this->marker.at(*node_id) = this->generation;
+						this->nodes.push_back(*node_id);
+					}
 				}
-				assert(found_communities.size() == node_ids_in_each_community.size());
-				assert(found_communities.size() == clique_ids_in_each_community.size());
-				const vector<int32_t> & com = current_percolation_level.get_com();
-				assert(com.size() == size_t(C));
-				for (int32_t c=0; c<C; c++) {
-					const int32_t comp_id_of_clique = com.at(c);
-					const clique & the_clique = the_cliques.at(c);
-					const int32_t size_of_clique = the_clique.size();
-					if(node_ids_in_each_community.count(comp_id_of_clique)) {
-						// this clique is in one of the found communities
-						assert(size_of_clique >= k);
-						tr1 :: unordered_set<int32_t> &node_ids_in_this_community
-							= node_ids_in_each_community.at(comp_id_of_clique);
-						for(int n=0; n<size_of_clique; n++) {
-							node_ids_in_this_community.insert(the_clique.at(n));
-						}
-						clique_ids_in_each_community.at(comp_id_of_clique).insert(c);
-					} else {
-						assert(size_of_clique < k);
+			}
+			sort(this->nodes.begin(), this->nodes.end());
+			for(size_t n = 0; n < this->nodes.size(); n++) {
+				if(n > 0)
+					out.comm.put(' ');
+				out.comm.append_name(this->names, this->nodes.at(n));
+			}
+			out.comm.put('\n');
+
+			if(this->with_percolated_cliques) {
+				out.percolated_cliques.append("Community ");
+				out.percolated_cliques.append_int(f);
+				out.percolated_cliques.append(" has ");
+				out.percolated_cliques.append_int(this->communities.begin.at(f+1) - this->communities.begin.at(f));
+				out.percolated_cliques.append(" cliques.\n");
+				for(int64_t i = this->communities.begin.at(f); i < this->communities.begin.at(f+1); i++) {
+					For(node_id, this->the_cliques.at(this->communities.cliques.at(i))) {
+						out.percolated_cliques.put(' ');
+						out.percolated_cliques.append_name(this->names, *node_id);
 					}
+					out.percolated_cliques.put('\n');
 				}
-				assert(found_communities.size() == node_ids_in_each_community.size());
 			}
-
+		}
+	}
+};
+static const int32_t COMMUNITIES_PER_CHUNK = 256;
+template<typename Id>
+struct community_rendering_worker : public threads :: runnable {
+	threads :: reorder_buffer<rendered_communities> &buffer;
+	community_renderer<Id> renderer;
+	const Id F;
+	community_rendering_worker(threads :: reorder_buffer<rendered_communities> &_buffer, const clique_set &the_cliques, const output :: node_name_cache &names, const communities_of_one_level<Id> &communities, bool with_percolated_cliques)
+		: buffer(_buffer), renderer(the_cliques, names, communities, with_percolated_cliques), F(communities.size()) {}
+	virtual void run() {
+		int64_t chunk_id;
+		while(-1 != (chunk_id = this->buffer.claim())) {
+			rendered_communities *r = new rendered_communities;
+			this->renderer.render(chunk_id * COMMUNITIES_PER_CHUNK, min(int64_t(this->F), (chunk_id+1) * COMMUNITIES_PER_CHUNK), *r);
+			this->buffer.finish(chunk_id, r);
+		}
+	}
+};
+static void write_text_buffer(output :: buffered_writer &out, const output :: text_buffer &text) {
+	unless(text.bytes.empty())
+		out.append(&text.bytes.front(), text.bytes.size());
+}
+template<typename Id>
+static void write_all_communities_for_this_k(const char * output_dir_name
+		, const int32_t k
+		, const vector<Id> &found_communities
+		, const comp<Id> & current_percolation_level
+		, const clique_set &the_cliques
+		, const output :: node_name_cache &names
+		) {
 			assert(output_dir_name);
+			communities_of_one_level<Id> communities;
+			bucket_cliques_by_community(found_communities, current_percolation_level, communities);
+			const Id F = communities.size();
+			assert(F == Id(found_communities.size()));
+			for(size_t i = 0; i < communities.cliques.size(); i++)
+				assert(int32_t(the_cliques.at(communities.cliques.at(i)).size()) >= k);
+			const bool with_percolated_cliques = !global_binary_output;
+
 			ostringstream output_file_name;
 			output_file_name << output_dir_name << "/" << "comm" << k;
-			ofstream write_nodes_here(output_file_name.str().c_str());
-
-			for (
-	map<int32_t, tr1 :: unordered_set<int32_t> > :: const_iterator i = node_ids_in_each_community.begin();
-	i != node_ids_in_each_community.end();
-	++i
-				)  { // communities
-				const set<int32_t> node_ids_in_this_community_sorted(i->second.begin(), i->second.end());
-				bool first_node_on_this_line = true;
-				for(std :: set<int32_t> :: const_iterator it = node_ids_in_this_community_sorted.begin()
-						; it != node_ids_in_this_community_sorted.end()
-						; ++it ) {
-					const int32_t node_id = *it;
-					const std :: string node_name = network->node_name_as_string(node_id);
-					if(!first_node_on_this_line)
-						write_nodes_here << ' ';
-					write_nodes_here << node_name;
-					first_node_on_this_line = false;
-				} // writing nodes
-				write_nodes_here << endl;
-			} // communities
-			write_nodes_here.close();
-
-			{	// detail the cliques in each comm
+			FILE * write_nodes_here = open_for_writing_or_die(output_file_name.str());
+			FILE * write_cliques_here = NULL;
+			if(with_percolated_cliques) {
 				ostringstream output_clique_file_name;
 				output_clique_file_name << output_dir_name << "/" << "percolated_cliques" << k;
-				ofstream write_cliques_here(output_clique_file_name.str().c_str());
-				int consecutive_comm_id = 0; // I don't think there is any guarantee that the clique_ids_in_each_community are consecutively numbered from zero, hence I'll count again.
-				For(comm_of_cliques, clique_ids_in_each_community) {
-					write_cliques_here << "Community " << consecutive_comm_id++ << " has " << comm_of_cliques->second.size() << " cliques." << endl;
-					For(one_clique_id, comm_of_cliques->second) {
-						const clique & the_clique_sorted = the_cliques.at(*one_clique_id);
-						For(node_id, the_clique_sorted) {
-							write_cliques_here << ' ' << network->node_name_as_string(*node_id);
-						}
-						write_cliques_here << endl;
+				write_cliques_here = open_for_writing_or_die(output_clique_file_name.str());
+			}
+			{
+				output :: buffered_writer comm_out(write_nodes_here);
+				auto_ptr<output :: buffered_writer> cliques_out(write_cliques_here ? new output :: buffered_writer(write_cliques_here) : NULL);
+				const int64_t num_chunks = (int64_t(F) + COMMUNITIES_PER_CHUNK - 1) / COMMUNITIES_PER_CHUNK;
+				if(global_num_threads == 1 || num_chunks <= 1) {
+					community_renderer<Id> renderer(the_cliques, names, communities, with_percolated_cliques);
+					for(int64_t chunk_id = 0; chunk_id < num_chunks; chunk_id++) {
+						rendered_communities r;
+						renderer.render(chunk_id * COMMUNITIES_PER_CHUNK, min(int64_t(F), (chunk_id+1) * COMMUNITIES_PER_CHUNK), r);
+						write_text_buffer(comm_out, r.comm);
+						if(cliques_out.get())
+							write_text_buffer(*cliques_out, r.percolated_cliques);
+					}
+				} else {
+					threads :: reorder_buffer<rendered_communities> buffer(num_chunks, 4 * global_num_threads, true);
+					vector<community_rendering_worker<Id> *> workers;
+					vector<threads :: thread *> running;
+					for(int t = 0; t < global_num_threads; t++) {
+						workers.push_back(new community_rendering_worker<Id>(buffer, the_cliques, names, communities, with_percolated_cliques));
+						running.push_back(start_thread_or_die(*workers.back()));
 					}
+					int64_t chunk_id;
+					while(rendered_communities *r = buffer.release(chunk_id)) {
+						write_text_buffer(comm_out, r->comm);
+						if(cliques_out.get())
+							write_text_buffer(*cliques_out, r->percolated_cliques);
+						delete r;
+					}
+					for(int t = 0; t < global_num_threads; t++) {
+						delete running.at(t); // joins
+						delete workers.at(t);
+					}
+				}
+				comm_out.flush();
+				if(cliques_out.get())
+					cliques_out->flush();
+			}
+			fclose(write_nodes_here);
+			if(write_cliques_here)
+				fclose(write_cliques_here);
+
+			if(global_binary_output) {
+				/* percolated_cliques<k>.bin, in the native byte order:
+				 *  - the 8 magic bytes "CLQCOM01", or "CLQCOM64" if the ids are 64-bit
+				 *  - int64: F, the number of communities
+				 *  - int64 * (F+1): offsets. Community f is made of ids[offsets[f], offsets[f+1])
+				 *  - int32 (or int64) * offsets[F]: the clique ids, i.e. indices into cliques.bin
+				 */
+				ostringstream output_clique_file_name;
+				output_clique_file_name << output_dir_name << "/" << "percolated_cliques" << k << ".bin";
+				FILE * f = open_for_writing_or_die(output_clique_file_name.str());
+				{
+					output :: buffered_writer out(f);
+					const int64_t num_communities = F;
+					out.append(sizeof(Id) == 4 ? "CLQCOM01" : "CLQCOM64", 8);
+					out.append(reinterpret_cast<const char *>(&num_communities), sizeof(num_communities));
+					out.append(reinterpret_cast<const char *>(&communities.begin.front()), sizeof(int64_t) * communities.begin.size());
+					unless(communities.cliques.empty())
+						out.append(reinterpret_cast<const char *>(&communities.cliques.front()), sizeof(Id) * communities.cliques.size());
+					out.flush();
 				}
-				write_cliques_here.close();
+				fclose(f);
 			}
 }
 
+template<typename Id>
 static void source_components_for_the_next_level ( // maybe this should return new_percolation_level ? via auto_ptr ?
-		vector<int32_t> &source_components
-		, vector<maybe_available>  & members_of_the_source_components
-		,       comp * new_percolation_level
+		vector<Id> &source_components
+		, vector< maybe_available<Id> >  & members_of_the_source_components
+		,       comp<Id> * new_percolation_level
 		, const int32_t new_k
-		, const vector<int32_t> & found_communities
-		, const comp * old_percolation_level
-		, const vector<clique> &the_cliques
+		, const vector<Id> & found_communities
+		, const comp<Id> * old_percolation_level
+		, const clique_set &the_cliques
 		) { // identify candidates for the next level
 	assert(source_components.empty());
 	assert(members_of_the_source_components.empty());
@@ -953,27 +3050,27 @@ static void source_components_for_the_next_level ( // maybe this should return n
 
 	// each found community at k becomes a source component at k+1
 
-	map<int32_t, maybe_available> the_cliques_in_each_community;
+	map<Id, maybe_available<Id> > the_cliques_in_each_community;
 	for(size_t f = 0; f < num_sources; f++) {
 		the_cliques_in_each_community[found_communities.at(f)]; // create the relevant entry in the map
 	}
 	assert(the_cliques_in_each_community.size() == num_sources);
-	for(int c=0; c<(int)the_cliques.size(); c++) {
+	for(Id c=0; c<new_percolation_level->size(); c++) { // every clique with new_k nodes is below that
 		if((int)the_cliques.at(c).size() >= new_k) {
-			const int32_t comp_id_in_old =  old_percolation_level->my_component_id(c);
+			const Id comp_id_in_old =  old_percolation_level->my_component_id(c);
 			assert(the_cliques_in_each_community.count(comp_id_in_old));
 			the_cliques_in_each_community[comp_id_in_old].insert(c);
 		}
 	}
 	assert(the_cliques_in_each_community.size() == num_sources);
 
-	for (map<int32_t, maybe_available> :: const_iterator i = the_cliques_in_each_community.begin()
+	for (typename map<Id, maybe_available<Id> > :: const_iterator i = the_cliques_in_each_community.begin()
 		 ; i != the_cliques_in_each_community.end()
 		 ; ++i) {
 		if(i->second.size()>0) { // this is worth passing up to the next level
-			const int32_t new_source = new_percolation_level->create_empty_component();
+			const Id new_source = new_percolation_level->create_empty_component();
 			source_components.push_back(new_source);
-			const vector<int32_t> &being_sent_up = i->second.get_all_members();
+			const vector<Id> &being_sent_up = i->second.get_all_members();
 			for(size_t j=0; j<being_sent_up.size(); j++) {
 				new_percolation_level->move_node(being_sent_up.at(j), new_source, 0);
 			}
@@ -984,3 +3081,303 @@ static void source_components_for_the_next_level ( // maybe this should return n
 	}
 	assert(source_components.size() == members_of_the_source_components.size());
 }
+
+/*
+ * --incremental PREV_DIR --edge-changes FILE brings the communities of an earlier run (with
+ * --binary-output, or an earlier --incremental) up to date with the new edge list, rather
+ * than starting again.
+ * Let A be the nodes at either end of a changed edge. A maximal clique without any node of
+ * A is maximal both before and after, so only the old cliques touching A are dropped, and
+ * only the new ones touching A are found (cliques :: cliquesTouchingNodesToCallback).
+ * Then, for each k, an old community that lost none of its cliques, and that no new clique
+ * overlaps by k-1 nodes, is still a community as it was. Only the other communities are
+ * percolated again, together with the new cliques.
+ */
+template<typename Id>
+static void percolate_the_changed_communities(const clique_set &the_cliques, const vector<bool> &survived, const int32_t min_k, const int32_t max_k_to_percolate, const string &previous_dir, const char * output_dir_name, const output :: node_name_cache &names);
+static void read_node_names_or_die(const string &file_name, vector<string> &node_names) {
+	ifstream in(file_name.c_str());
+	unless(in) {
+		cerr << endl << "Error: couldn't open \"" << file_name << "\". Exiting." << endl;
+		exit(1);
+	}
+	string name;
+	while(getline(in, name))
+		node_names.push_back(name);
+}
+template<typename Id>
+static bool read_percolated_cliques_bin(const string &file_name, vector<int64_t> &begin, vector<Id> &ids) { // false if there's no such file
+	FILE * f = fopen(file_name.c_str(), "rb");
+	if(!f)
+		return false;
+	char magic[8];
+	int64_t F = -1;
+	read_or_die(f, magic, sizeof(magic), file_name);
+	read_or_die(f, &F, sizeof(F), file_name);
+	const bool wide = memcmp(magic, "CLQCOM64", 8) == 0;
+	if((!wide && memcmp(magic, "CLQCOM01", 8) != 0) || F < 0) {
+		cerr << endl << "Error: \"" << file_name << "\" isn't a percolated_cliques<k>.bin file. Exiting." << endl;
+		exit(1);
+	}
+	begin.resize(F+1);
+	read_or_die(f, &begin.front(), sizeof(int64_t) * begin.size(), file_name);
+	ids.resize(begin.back());
+	read_ids_or_die(f, ids, wide ? 8 : 4, file_name);
+	fclose(f);
+	return true;
+}
+static bool file_exists(const string &file_name) {
+	struct stat st;
+	return stat(file_name.c_str(), &st) == 0;
+}
+struct clique_collector : public cliques :: clique_callback {
+	clique_set &into;
+	explicit clique_collector(clique_set &_into) : into(_into) {}
+	virtual void receive_sorted_clique(const int32_t * nodes, size_t size) {
+		this->into.push_back(nodes, nodes + size);
+	}
+};
+static void read_edge_changes_or_die(const char * changes_file_name
+		, const tr1 :: unordered_map<string, int32_t> &old_id
+		, const tr1 :: unordered_map<string, int32_t> &new_id
+		, const SimpleIntGraph g
+		, vector<int32_t> &touched_old
+		, vector<int32_t> &touched_new
+		) {
+	/* One change per line: "+ a b" for an added edge, "- a b" for a removed one.
+	 * Blank lines, and lines starting with #, are skipped.
+	 */
+	ifstream in(changes_file_name);
+	unless(in) {
+		cerr << endl << "Error: couldn't open \"" << changes_file_name << "\". Exiting." << endl;
+		exit(1);
+	}
+	string line;
+	int64_t line_number = 0;
+	int64_t added = 0, removed = 0;
+	while(getline(in, line)) {
+		++ line_number;
+		istringstream fields(line);
+		string sign, a, b, extra;
+		unless(fields >> sign) // blank
+			continue;
+		if(sign.at(0) == '#')
+			continue;
+		if((sign != "+" && sign != "-") || !(fields >> a >> b) || (fields >> extra)) {
+			cerr << endl << "Error: line " << line_number << " of \"" << changes_file_name << "\" should be \"+ node node\" or \"- node node\". Exiting." << endl;
+			exit(1);
+		}
+		const string * ends[2] = { &a, &b };
+		int32_t in_new[2];
+		for(int e = 0; e < 2; e++) {
+			tr1 :: unordered_map<string, int32_t> :: const_iterator it = old_id.find(*ends[e]);
+			if(it != old_id.end())
+				touched_old.push_back(it->second);
+			it = new_id.find(*ends[e]);
+			in_new[e] = it == new_id.end() ? -1 : it->second;
+			if(in_new[e] != -1)
+				touched_new.push_back(in_new[e]);
+		}
+		const bool in_the_edge_list = in_new[0] != -1 && in_new[1] != -1 && g->are_connected(in_new[0], in_new[1]);
+		if(in_the_edge_list != (sign == "+")) {
+			cerr << endl << "Error: line " << line_number << " of \"" << changes_file_name << "\" " << (sign == "+" ? "adds" : "removes")
+				<< " the edge " << a << " " << b << ", but the edge list " << (sign == "+" ? "doesn't have" : "still has") << " it. Exiting." << endl;
+			exit(1);
+		}
+		++ (sign == "+" ? added : removed);
+	}
+	sort(touched_old.begin(), touched_old.end());
+	touched_old.erase(unique(touched_old.begin(), touched_old.end()), touched_old.end());
+	sort(touched_new.begin(), touched_new.end());
+	touched_new.erase(unique(touched_new.begin(), touched_new.end()), touched_new.end());
+	PP2(added, removed);
+}
+static void update_communities_incrementally(const graph :: NetworkInterfaceConvertedToString *net, const int32_t min_k, const int32_t max_k, const char * previous_dir_name, const char * changes_file_name, const char * output_dir_name) {
+	const string previous_dir(previous_dir_name);
+	const SimpleIntGraph g = net->get_plain_graph();
+	const output :: node_name_cache names(net);
+	tr1 :: unordered_map<string, int32_t> new_id;
+	for(int32_t n = 0; n < names.numNodes(); n++)
+		new_id[names.name_as_string(n)] = n;
+	vector<string> old_names;
+	read_node_names_or_die(previous_dir + "/node_names", old_names);
+	tr1 :: unordered_map<string, int32_t> old_id;
+	for(size_t n = 0; n < old_names.size(); n++)
+		old_id[old_names.at(n)] = n;
+
+	vector<int32_t> touched_old, touched_new;
+	read_edge_changes_or_die(changes_file_name, old_id, new_id, g, touched_old, touched_new);
+	vector<bool> is_touched_old(old_names.size(), false);
+	For(n, touched_old)
+		is_touched_old.at(*n) = true;
+
+	{ // the previous run must have had the same -k. Its lowest level tells us
+		ostringstream lowest, below_that;
+		lowest << previous_dir << "/percolated_cliques" << min_k << ".bin";
+		below_that << previous_dir << "/percolated_cliques" << min_k - 1 << ".bin";
+		if(!file_exists(lowest.str()) || file_exists(below_that.str())) {
+			cerr << endl << "Error: \"" << previous_dir << "\" isn't from a run with --binary-output (or --incremental) and -k " << min_k << ". Exiting." << endl;
+			exit(1);
+		}
+	}
+	clique_set old_cliques;
+	try {
+		old_cliques.map_file(previous_dir + "/cliques.bin");
+	} catch (std :: runtime_error &e) {
+		cerr << endl << "Error: " << e.what() << ". Exiting." << endl;
+		exit(1);
+	}
+
+	// the cliques that survive, in their old order, then those found again
+	clique_set the_cliques;
+	vector<bool> survived(old_cliques.size(), false); // [old clique id]
+	{
+		vector<int32_t> renamed;
+		for(size_t c = 0; c < old_cliques.size(); c++) {
+			const clique cl = old_cliques.at(c);
+			bool touched = false;
+			For(n, cl)
+				if(is_touched_old.at(*n))
+					touched = true;
+			if(touched)
+				continue;
+			renamed.clear();
+			For(n, cl)
+				renamed.push_back(new_id.find(old_names.at(*n))->second); // untouched, hence still in the edge list
+			sort(renamed.begin(), renamed.end()); // the new ids needn't be in the same order
+			survived.at(c) = true;
+			the_cliques.push_back(&renamed.front(), &renamed.front() + renamed.size());
+		}
+	}
+	const int64_t survivors = the_cliques.size();
+	{
+		clique_collector collect(the_cliques);
+		cliques :: cliquesTouchingNodesToCallback(g, min_k, touched_new, collect);
+	}
+	const int64_t C = the_cliques.size();
+	const int64_t dropped = old_cliques.size() - survivors;
+	const int64_t found_again = C - survivors;
+	PP4(old_cliques.size(), dropped, found_again, C);
+	if(C==0) {
+		cerr << endl << "Error: you don't have any cliques of at least size " << min_k << ". Exiting." << endl;
+		exit(1);
+	}
+	create_directory_for_output(output_dir_name);
+	save_cliques_or_die(the_cliques, string(output_dir_name) + "/cliques.bin");
+	save_node_names_or_die(names, string(output_dir_name) + "/node_names");
+
+	int32_t max_k_to_percolate = min_k;
+	for(int64_t c = 0; c < C; c++)
+		max_k_to_percolate = max(max_k_to_percolate, int32_t(the_cliques.at(c).size()));
+	max_k_to_percolate = min(max_k_to_percolate, max_k);
+
+	if(small_enough_for_32_bit_ids(max(int64_t(old_cliques.size()), C))) // the old ids, in percolated_cliques<k>.bin, too
+		percolate_the_changed_communities<int32_t>(the_cliques, survived, min_k, max_k_to_percolate, previous_dir, output_dir_name, names);
+	else
+		percolate_the_changed_communities<int64_t>(the_cliques, survived, min_k, max_k_to_percolate, previous_dir, output_dir_name, names);
+}
+template<typename Id>
+static void percolate_the_changed_communities(const clique_set &the_cliques, const vector<bool> &survived, const int32_t min_k, const int32_t max_k_to_percolate, const string &previous_dir, const char * output_dir_name, const output :: node_name_cache &names) {
+	const Id C = the_cliques.size();
+	vector<Id> new_clique_id(survived.size(), -1); // [old clique id]. -1 if dropped
+	Id survivors = 0;
+	for(size_t c = 0; c < survived.size(); c++)
+		if(survived.at(c))
+			new_clique_id.at(c) = survivors ++;
+
+	// for the overlaps between the new cliques and the survivors: the survivors on each node of a new clique
+	tr1 :: unordered_map<int32_t, vector<Id> > survivors_on_node;
+	for(Id c = survivors; c < C; c++)
+		For(n, the_cliques.at(c))
+			survivors_on_node[*n];
+	for(Id c = 0; c < survivors; c++)
+		For(n, the_cliques.at(c)) {
+			typename tr1 :: unordered_map<int32_t, vector<Id> > :: iterator it = survivors_on_node.find(*n);
+			if(it != survivors_on_node.end())
+				it->second.push_back(c);
+		}
+
+	vector<Id> C_k; // the survivors and the new cliques aren't sorted by size, but the comps can still stop at the last clique big enough
+	cliques_of_each_level(the_cliques, max_k_to_percolate, C_k);
+	background_level_writer<Id> writer(output_dir_name, the_cliques, names, NULL);
+	for(int32_t k = min_k; k <= max_k_to_percolate; k++) {
+		vector<int64_t> old_begin;
+		vector<Id> old_members;
+		ostringstream old_file_name;
+		old_file_name << previous_dir << "/percolated_cliques" << k << ".bin";
+		unless(read_percolated_cliques_bin(old_file_name.str(), old_begin, old_members))
+			old_begin.assign(1, 0); // no old clique is this big. That's checked below
+		const Id F_old = old_begin.size() - 1;
+
+		vector<Id> community_of(survivors, -1); // [new clique id]. The old community at this k
+		vector<bool> dirty(F_old, false);
+		for(Id f = 0; f < F_old; f++)
+			for(int64_t x = old_begin.at(f); x < old_begin.at(f+1); x++) {
+				const Id c = new_clique_id.at(old_members.at(x));
+				if(c == -1)
+					dirty.at(f) = true;
+				else
+					community_of.at(c) = f;
+			}
+		for(Id c = 0; c < survivors; c++)
+			if(community_of.at(c) == -1 && int32_t(the_cliques.at(c).size()) >= k) {
+				cerr << endl << "Error: \"" << previous_dir << "\" has no communities for k = " << k << ", or they don't match its cliques.bin. Was it run with -K? Exiting." << endl;
+				exit(1);
+			}
+		percolation_task<Id> task;
+		task.k = k;
+		vector<Id> new_cliques_here;
+		for(Id c = survivors; c < C; c++) {
+			if(int32_t(the_cliques.at(c).size()) < k)
+				continue;
+			new_cliques_here.push_back(c);
+			tr1 :: unordered_map<Id, int32_t> overlap; // survivor -> the nodes it shares with c
+			For(n, the_cliques.at(c))
+				For(s, survivors_on_node[*n])
+					if(int32_t(the_cliques.at(*s).size()) >= k)
+						++ overlap[*s];
+			For(o, overlap)
+				if(o->second >= k-1)
+					dirty.at(community_of.at(o->first)) = true;
+		}
+
+		vector< vector<Id> > communities;
+		Id redone = 0;
+		for(Id f = 0; f < F_old; f++) {
+			if(dirty.at(f)) {
+				++ redone;
+				for(int64_t x = old_begin.at(f); x < old_begin.at(f+1); x++) {
+					const Id c = new_clique_id.at(old_members.at(x));
+					if(c != -1)
+						task.cliques.push_back(c);
+				}
+			} else {
+				communities.push_back(vector<Id>());
+				for(int64_t x = old_begin.at(f); x < old_begin.at(f+1); x++)
+					communities.back().push_back(new_clique_id.at(old_members.at(x)));
+			}
+		}
+		sort(task.cliques.begin(), task.cliques.end());
+		task.cliques.insert(task.cliques.end(), new_cliques_here.begin(), new_cliques_here.end()); // all bigger than the survivors' ids
+		unless(task.cliques.empty()) {
+			vector< vector<Id> > percolated;
+			percolate_one_source_component(the_cliques, task, percolated, string(output_dir_name) + "/component0.tmp");
+			For(comm, percolated) {
+				communities.push_back(vector<Id>());
+				communities.back().swap(*comm);
+			}
+		}
+		cout << "k = " << k << ": percolated " << redone << " of the " << F_old << " old communities again, with " << new_cliques_here.size() << " new cliques, " << task.cliques.size() << " cliques in all. " << HOWLONG << endl;
+		sort(communities.begin(), communities.end(), first_clique_first()); // as do_clique_percolation_in_parallel does
+
+		comp<Id> * level = new comp<Id>(C_k.at(k)); // cliques still in component 0 are too small for this k
+		vector<Id> found_communities;
+		For(comm, communities) {
+			const Id component_id = level->create_empty_component();
+			found_communities.push_back(component_id);
+			For(c, *comm)
+				level->move_node(*c, component_id, 0);
+		}
+		writer.write(k, found_communities, level);
+	}
+}
@@ -5,6 +5,7 @@ using namespace std;
 #include <getopt.h>
 #include <libgen.h>
 #include <ctime>
+#include <stdexcept>
 
 #include "macros.hpp"
 #include "cliques.hpp"
@@ -19,10 +20,14 @@ int main(int argc, char **argv) {
 	if (cmdline_parser (argc, argv, &args_info) != 0)
 		exit(1) ;
 	// .. and there should be exactly one non-option arg
-	if(args_info.inputs_num != 1 || args_info.k_arg < 3) {
+	if(args_info.inputs_num != 1 || args_info.k_arg < 3 || args_info.threads_arg < 1) {
 		cmdline_parser_print_help();
 		exit(1);
 	}
+	if(args_info.previous_given != args_info.edge_changes_given) {
+		cerr << "Error: --previous and --edge-changes go together. Exiting." << endl;
+		exit(1);
+	}
 
 	const char * edgeListFileName   = args_info.inputs[0];
 	const int k = args_info.k_arg;
@@ -41,7 +46,22 @@ int main(int argc, char **argv) {
 		<< " Max degree is " << maxDegree
 	       << endl;
 
+	if(args_info.previous_given) {
+		try {
+			cliques :: cliqueDeltaToStdout(network.get(), k, args_info.previous_arg, args_info.edge_changes_arg);
+		} catch (std :: runtime_error &e) {
+			cerr << endl << "Error: " << e.what() << ". Exiting." << endl;
+			exit(1);
+		}
+		return 0;
+	}
+
 	// cliques::cliquesToStdout(g.get(), k);
-	cliques :: cliquesToStdout(network.get(), k);
+	try {
+		cliques :: cliquesToStdout(network.get(), k, args_info.threads_arg, args_info.deterministic_flag);
+	} catch (std :: runtime_error &e) { // e.g. a thread couldn't be started
+		cerr << endl << "Error: " << e.what() << ". Exiting." << endl;
+		exit(1);
+	}
 
 }
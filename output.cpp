@@ -0,0 +1,59 @@
+#include "output.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+using namespace std;
+
+namespace output {
+
+node_name_cache :: node_name_cache(const graph :: NetworkInterfaceConvertedToString *net) {
+	assert(net);
+	const int32_t N = net->numNodes();
+	this->offsets.reserve(N+1);
+	this->offsets.push_back(0);
+	for(int32_t n = 0; n < N; n++) {
+		const string name = net->node_name_as_string(n); // the only time each name is converted
+		this->bytes.insert(this->bytes.end(), name.begin(), name.end());
+		this->offsets.push_back(int64_t(this->bytes.size()));
+	}
+	this->bytes.push_back('\0'); // so that name_begin() is valid even when every name is empty
+	vector<char>(this->bytes).swap(this->bytes); // trim the excess capacity
+}
+
+buffered_writer :: buffered_writer(FILE *_out, size_t capacity) : out(_out), buf(capacity), used(0) {
+	assert(this->out);
+	assert(capacity > 0);
+}
+buffered_writer :: ~buffered_writer() {
+	if(this->used > 0) // best effort. Call flush() explicitly if you want to hear about errors
+		fwrite(&this->buf.front(), 1, this->used, this->out);
+}
+size_t format_int(int64_t i, char digits[24]) {
+	size_t len = 0;
+	const bool negative = i < 0;
+	uint64_t u = negative ? uint64_t(-(i+1)) + 1 : uint64_t(i);
+	do {
+		digits[len++] = char('0' + u % 10);
+		u /= 10;
+	} while(u);
+	if(negative)
+		digits[len++] = '-';
+	reverse(digits, digits + len);
+	return len;
+}
+void buffered_writer :: append_int(int64_t i) {
+	char digits[24];
+	this->append(digits, format_int(i, digits));
+}
+void buffered_writer :: flush() {
+	if(this->used > 0)
+		this->write_or_die(&this->buf.front(), this->used);
+	this->used = 0;
+}
+void buffered_writer :: write_or_die(const char *p, const size_t n) {
+	if(fwrite(p, 1, n, this->out) != n)
+		throw std :: runtime_error("couldn't write output");
+}
+
+} // namespace output
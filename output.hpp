@@ -0,0 +1,88 @@
+#ifndef _OUTPUT_HPP_
+#define _OUTPUT_HPP_
+
+#include "graph/network.hpp"
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+
+namespace output {
+
+size_t format_int(int64_t i, char digits[24]); // writes the decimal digits, no '\0'. Returns how many
+
+class node_name_cache { // every node name, rendered once into one contiguous buffer. Shared by all the writers.
+	std :: vector<char> bytes;
+	std :: vector<int64_t> offsets; // N+1 entries. The name of node n is bytes[offsets[n], offsets[n+1])
+public:
+	explicit node_name_cache(const graph :: NetworkInterfaceConvertedToString *net);
+	int32_t numNodes() const { return int32_t(this->offsets.size()) - 1; }
+	const char * name_begin(const int32_t node_id) const { return &this->bytes.front() + this->offsets[node_id]; }
+	size_t name_length(const int32_t node_id) const { return size_t(this->offsets[node_id+1] - this->offsets[node_id]); }
+	std :: string name_as_string(const int32_t node_id) const { return std :: string(this->name_begin(node_id), this->name_length(node_id)); }
+};
+
+class buffered_writer { // collects output in a large buffer, and hands it to stdio in big sequential writes
+	FILE * out;
+	std :: vector<char> buf;
+	size_t used;
+	buffered_writer(const buffered_writer &); // not copyable
+	buffered_writer & operator= (const buffered_writer &);
+public:
+	explicit buffered_writer(FILE *_out, size_t capacity = (1 << 22));
+	~buffered_writer();
+	void append(const char *p, const size_t n) {
+		if(this->used + n > this->buf.size()) {
+			this->flush();
+			if(n > this->buf.size()) { // too big to bother buffering
+				this->write_or_die(p, n);
+				return;
+			}
+		}
+		std :: copy(p, p+n, &this->buf.front() + this->used); // a plain memcpy
+		this->used += n;
+	}
+	void append(const char *s) {
+		this->append(s, strlen(s));
+	}
+	void put(const char c) {
+		if(this->used == this->buf.size())
+			this->flush();
+		this->buf[this->used++] = c;
+	}
+	void append_name(const node_name_cache &names, const int32_t node_id) {
+		this->append(names.name_begin(node_id), names.name_length(node_id));
+	}
+	void append_int(int64_t i);
+	void flush();
+private:
+	void write_or_die(const char *p, const size_t n);
+};
+
+class text_buffer { // same interface as buffered_writer, but just keeps everything in memory
+public:
+	std :: vector<char> bytes;
+	void append(const char *p, const size_t n) {
+		this->bytes.insert(this->bytes.end(), p, p+n);
+	}
+	void append(const char *s) {
+		this->append(s, strlen(s));
+	}
+	void put(const char c) {
+		this->bytes.push_back(c);
+	}
+	void append_name(const node_name_cache &names, const int32_t node_id) {
+		this->append(names.name_begin(node_id), names.name_length(node_id));
+	}
+	void append_int(int64_t i) {
+		char digits[24];
+		this->append(digits, format_int(i, digits));
+	}
+};
+
+} // namespace output
+
+#endif
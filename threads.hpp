@@ -0,0 +1,212 @@
+#ifndef _THREADS_HPP_
+#define _THREADS_HPP_
+
+/*
+ * Thin wrappers around pthreads: a mutex, a condition variable, a joinable thread,
+ * a bounded, blocking, queue and a reorder buffer. That's all we need for the producer/consumer
+ * and worker-pool code, and it keeps the rest of the code base in gnu++98.
+ */
+
+#include <pthread.h>
+#include <deque>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <cassert>
+#include <stdint.h>
+
+namespace threads {
+
+class mutex {
+	pthread_mutex_t m;
+	mutex(const mutex &);
+	mutex & operator= (const mutex &);
+public:
+	mutex() { pthread_mutex_init(&this->m, NULL); }
+	~mutex() { pthread_mutex_destroy(&this->m); }
+	void lock() { pthread_mutex_lock(&this->m); }
+	void unlock() { pthread_mutex_unlock(&this->m); }
+	pthread_mutex_t * native() { return &this->m; }
+};
+
+class lock { // scoped lock
+	mutex &m;
+	lock(const lock &);
+	lock & operator= (const lock &);
+public:
+	explicit lock(mutex &_m) : m(_m) { this->m.lock(); }
+	~lock() { this->m.unlock(); }
+};
+
+class condition {
+	pthread_cond_t c;
+	condition(const condition &);
+	condition & operator= (const condition &);
+public:
+	condition() { pthread_cond_init(&this->c, NULL); }
+	~condition() { pthread_cond_destroy(&this->c); }
+	void wait(mutex &m) { pthread_cond_wait(&this->c, m.native()); } // m must be locked by the caller
+	void signal() { pthread_cond_signal(&this->c); }
+	void broadcast() { pthread_cond_broadcast(&this->c); }
+};
+
+struct runnable {
+	virtual void run() = 0;
+	virtual ~runnable() {}
+};
+
+class thread { // starts r.run() on a new thread. You must join() before r goes away
+	pthread_t t;
+	bool joinable;
+	thread(const thread &);
+	thread & operator= (const thread &);
+	static void * trampoline(void *r) {
+		static_cast<runnable *>(r)->run();
+		return NULL;
+	}
+public:
+	explicit thread(runnable &r) : joinable(false) { // throws std :: runtime_error if the thread can't be started
+		const int ret = pthread_create(&this->t, NULL, trampoline, &r);
+		if(ret != 0)
+			throw std :: runtime_error(std :: string("couldn't start a thread: ") + strerror(ret));
+		this->joinable = true;
+	}
+	~thread() { this->join(); }
+	void join() {
+		if(this->joinable)
+			pthread_join(this->t, NULL);
+		this->joinable = false;
+	}
+};
+
+template <typename T>
+class bounded_queue { // push() blocks while full, pop() blocks while empty. Items are swap()ped in and out, never copied, so give T a cheap swap()
+	std :: deque<T> items;
+	const size_t capacity;
+	bool closed;    // the producer has finished, no more pushes
+	bool cancelled; // the consumer has given up, pushes are refused
+	mutex m;
+	condition not_empty;
+	condition not_full;
+	bounded_queue(const bounded_queue &);
+	bounded_queue & operator= (const bounded_queue &);
+public:
+	explicit bounded_queue(size_t _capacity) : capacity(_capacity > 0 ? _capacity : 1), closed(false), cancelled(false) {}
+	bool push(T &item) { // returns false if the consumer has cancelled. item is left empty
+		lock l(this->m);
+		while(this->items.size() >= this->capacity && !this->cancelled)
+			this->not_full.wait(this->m);
+		if(this->cancelled)
+			return false;
+		this->items.push_back(T());
+		using std :: swap;
+		swap(this->items.back(), item);
+		this->not_empty.signal();
+		return true;
+	}
+	bool pop(T &item) { // returns false once the queue is closed and drained
+		lock l(this->m);
+		while(this->items.empty() && !this->closed && !this->cancelled)
+			this->not_empty.wait(this->m);
+		if(this->items.empty())
+			return false;
+		using std :: swap;
+		swap(item, this->items.front());
+		this->items.pop_front();
+		this->not_full.signal();
+		return true;
+	}
+	void close() { // called by the producer when it's done
+		lock l(this->m);
+		this->closed = true;
+		this->not_empty.broadcast();
+	}
+	void cancel() { // called by the consumer to release a blocked producer
+		lock l(this->m);
+		this->cancelled = true;
+		this->items.clear();
+		this->not_full.broadcast();
+		this->not_empty.broadcast();
+	}
+	bool is_cancelled() {
+		lock l(this->m);
+		return this->cancelled;
+	}
+};
+
+/*
+ * For work cut into numbered chunks: workers claim() chunk ids, fill them in, and finish() them,
+ * and one consumer release()s the finished chunks. If in_order, chunks are released strictly
+ * in chunk id order, whatever order they finish in; otherwise, as soon as they finish.
+ * At most 'window' chunks may be claimed-but-not-yet-released. Workers wait for the
+ * consumer beyond that, so memory use is bounded no matter how uneven the chunks are.
+ * If not all the workers could be started, cancel() lets the ones that were finish up.
+ */
+template <typename Chunk>
+class reorder_buffer {
+	mutex m;
+	condition changed;
+	std :: map<int64_t, Chunk *> finished;
+	const int64_t num_chunks;
+	const int64_t window;
+	const bool in_order;
+	int64_t next_to_claim;
+	int64_t num_released; // if in_order, this is also the id of the next chunk to be released
+	bool cancelled;
+public:
+	reorder_buffer(int64_t _num_chunks, int64_t _window, bool _in_order)
+		: num_chunks(_num_chunks), window(_window), in_order(_in_order), next_to_claim(0), num_released(0), cancelled(false) {
+		assert(this->window >= 1);
+	}
+	int64_t claim() { // the next chunk_id for a worker to fill in, or -1 if there are none left
+		lock l(this->m);
+		while(!this->cancelled && this->next_to_claim < this->num_chunks && this->next_to_claim >= this->num_released + this->window)
+			this->changed.wait(this->m); // backpressure
+		if(this->cancelled || this->next_to_claim >= this->num_chunks)
+			return -1;
+		return this->next_to_claim++;
+	}
+	void finish(int64_t chunk_id, Chunk *c) {
+		lock l(this->m);
+		if(this->cancelled) {
+			delete c;
+			return;
+		}
+		this->finished[chunk_id] = c;
+		this->changed.broadcast();
+	}
+	Chunk * release(int64_t &chunk_id) { // for the consumer. Waits for the next releasable chunk. NULL at the end
+		lock l(this->m);
+		while(1) {
+			if(this->cancelled || this->num_released == this->num_chunks)
+				return NULL;
+			typename std :: map<int64_t, Chunk *> :: iterator it = this->in_order
+				? this->finished.find(this->num_released)
+				: this->finished.begin();
+			if(it != this->finished.end()) {
+				chunk_id = it->first;
+				Chunk *c = it->second;
+				this->finished.erase(it);
+				++ this->num_released;
+				this->changed.broadcast();
+				return c;
+			}
+			this->changed.wait(this->m);
+		}
+	}
+	void cancel() { // no more chunks are claimed or released, and the finished ones are deleted
+		lock l(this->m);
+		this->cancelled = true;
+		for(typename std :: map<int64_t, Chunk *> :: iterator it = this->finished.begin(); it != this->finished.end(); ++it)
+			delete it->second;
+		this->finished.clear();
+		this->changed.broadcast();
+	}
+};
+
+} // namespace threads
+
+#endif